@@ -2,11 +2,15 @@
 //Friday July 11th, 2025
 
 #include "../../module.h"
-#include "mos6502-nmos.h"
+#include "appleiibus.h"
+#include "../MOS6502/mos6502.h"
 
 namespace Cores::Apple2{
 	
 	class System:public Module{
 		
+		private:
+		Bus bus;
+		Mos6502<Bus, Mos6502Variants::Nmos> cpu{bus, 0x100};
 	};
 };
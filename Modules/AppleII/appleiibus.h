@@ -1,13 +1,37 @@
 #pragma once
+#include "../MOS6502/memorymap.h"
 
-struct{
-	uint8_t mem[49152];
+namespace Cores::Apple2{
 	
-	uint8_t read(uint16_t addr){
-		return mem[addr];
-	}
-	
-	void write(int8_t val, uint16_t addr){
-		mem[addr] = val;
-	}
-} appleiibus;
+	struct Bus{
+		uint8_t mem[49152] = {};
+		uint8_t rom[12288] = {}; //$D000-$FFFF, the language card can swap RAM in here
+		MemoryMap map;
+		
+		//The soft switches and slot I/O, disk included. None of them are emulated yet.
+		static uint8_t readSwitch(void *, uint16_t){
+			return 0;
+		}
+		
+		static void writeSwitch(void *, uint8_t, uint16_t){}
+		
+		Bus(){
+			map.mapMemory(0x00, 0xC0, mem, sizeof(mem), true);
+			map.mapIo(0xC0, 0x01, readSwitch, writeSwitch, this);
+			//$C100-$CFFF is left for the slot ROMs
+			map.mapMemory(0xD0, 0x30, rom, sizeof(rom), false);
+		}
+		
+		bool timed(uint16_t addr){
+			return map.isIo(addr);
+		}
+		
+		uint8_t read(uint16_t addr){
+			return map.read(addr);
+		}
+		
+		void write(int8_t val, uint16_t addr){
+			map.write(val, addr);
+		}
+	};
+}
@@ -0,0 +1,22 @@
+//CPU testing bus. Flat 64K of RAM, nothing mapped.
+//Saturday 17th of October, 2026
+#pragma once
+
+namespace Cores::CPUTest{
+	
+	struct Bus{
+		uint8_t mem[65536] = {};
+		
+		static bool timed(uint16_t){
+			return false;
+		}
+		
+		uint8_t read(uint16_t addr){
+			return mem[addr];
+		}
+		
+		void write(int8_t val, uint16_t addr){
+			mem[addr] = val;
+		}
+	};
+}
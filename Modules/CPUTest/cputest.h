@@ -2,12 +2,17 @@
 //Tuesday July 15th, 2025
 
 #include "../../module.h"
-#include "mos6502-nmos.h"
+#include "bus.h"
+#include "../MOS6502/mos6502.h"
 
 namespace Cores::CPUTest{
 	
 	class System:public Module{
 		
+		private:
+		Bus bus;
+		Mos6502<Bus, Mos6502Variants::Nmos> cpu{bus, 0x100};
+		
 		public:
 		
 		int16_t* playAudio() override{
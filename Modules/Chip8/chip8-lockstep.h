@@ -0,0 +1,504 @@
+//Lockstep Chip-8 engine for MOSES. Runs a group of machines side by side so one decoded instruction
+//drives every lane at once. Only worth it when many instances run the same ROM, see batch.h.
+//Saturday 17th of October, 2026
+#pragma once
+#include "chip8.h"
+
+namespace Cores::Chip8{
+
+	template<int lanes>
+	struct LockstepCpu{
+		//Same machine as Cpu, but every piece of state is an array over lanes, indexed [what][lane].
+		//Lanes whose next opcode matches are executed together under a byte mask (0xFF = lane takes
+		//part), so the register file updates compile down to vector blends. Divergent lanes are
+		//regrouped by opcode and run one group after another.
+
+		uint8_t mem[4096][lanes] = {};
+		uint8_t v[16][lanes] = {};
+		uint16_t i[lanes] = {};
+		uint16_t pc[lanes];
+		uint8_t sp[lanes] = {};
+		uint8_t dt[lanes] = {};
+		uint8_t st[lanes] = {};
+		uint16_t stack[12][lanes] = {};
+		uint64_t display[32][lanes] = {}; //One row per word, bit 63 is the leftmost pixel
+		bool key[16][lanes] = {};
+		uint8_t tempKey[lanes];
+		bool release[lanes];
+		bool displayWait = true;
+		uint64_t executed[lanes] = {};
+		Random rng[lanes]; //Lane n gets the seed plus n, so it matches a lone Cpu started with that
+
+		LockstepCpu(){
+			for(int l = 0; l < lanes; l++){
+				rng[l].reseed(Random::defaultSeed + l);
+				pc[l] = 0x200;
+				tempKey[l] = 16;
+				release[l] = true;
+			}
+		}
+
+		uint8_t read(uint16_t addr, int lane){
+			if(addr > 4095){
+				std::cout << "GURU MEDITATION mem out of bounds read\n";
+				return 0;
+			}else{
+				return mem[addr][lane];
+			}
+		}
+
+		void write(uint8_t val, uint16_t addr, int lane){
+			if(addr > 4095){
+				std::cout << "GURU MEDITATION mem out of bounds write\n";
+			}else{
+				mem[addr][lane] = val;
+			}
+		}
+
+		void decTimers(){
+			for(int l = 0; l < lanes; l++){
+				dt[l] -= (dt[l] > 0);
+				st[l] -= (st[l] > 0);
+			}
+		}
+
+		//Runs one opcode on every lane in mask. live is cleared for lanes that have to stop for the frame.
+		void execute(uint16_t opcode, const uint8_t *mask, uint8_t *live){
+			uint8_t x = (opcode & 0x0F00) >> 8;
+			uint8_t y = (opcode & 0x00F0) >> 4;
+			uint8_t nn = (opcode & 0x00FF);
+			uint16_t nnn = (opcode & 0x0FFF);
+			uint8_t flag[lanes];
+			uint8_t result[lanes];
+			for(int l = 0; l < lanes; l++){
+				pc[l] += mask[l] & 2;
+			}
+			switch((opcode & 0xF000) >> 12){
+				case 0x00:
+					switch(opcode){
+						case 0x00E0: //CLS
+							for(int row = 0; row < 32; row++){
+								for(int l = 0; l < lanes; l++){
+									display[row][l] &= ~(uint64_t)(int8_t)mask[l];
+								}
+							}
+							break;
+						case 0x00EE: //RET
+							for(int l = 0; l < lanes; l++){
+								if(mask[l]){
+									if(sp[l] == 0){
+										std::cout << "GURU MEDITATION return outside of subroutine\n";
+									}else{
+										sp[l]--;
+										pc[l] = stack[sp[l]][l];
+									}
+								}
+							}
+							break;
+						default:
+							std::cout << "GURU MEDITATION unknown opcode\n";
+							break;
+					}
+					break;
+				case 0x01: //JP
+					for(int l = 0; l < lanes; l++){
+						pc[l] = (pc[l] & ~(uint16_t)(int8_t)mask[l]) | (nnn & (uint16_t)(int8_t)mask[l]);
+					}
+					break;
+				case 0x02: //CALL
+					for(int l = 0; l < lanes; l++){
+						if(mask[l]){
+							if(sp[l] > 11){
+								std::cout << "GURU MEDITATION too many nested subroutines\n";
+							}else{
+								stack[sp[l]][l] = pc[l];
+								sp[l]++;
+								pc[l] = nnn;
+							}
+						}
+					}
+					break;
+				case 0x03: //SE
+					for(int l = 0; l < lanes; l++){
+						pc[l] += mask[l] & -(v[x][l] == nn) & 2;
+					}
+					break;
+				case 0x04: //SNE
+					for(int l = 0; l < lanes; l++){
+						pc[l] += mask[l] & -(v[x][l] != nn) & 2;
+					}
+					break;
+				case 0x05: //SE
+					if((opcode & 0x000F) == 0){
+						for(int l = 0; l < lanes; l++){
+							pc[l] += mask[l] & -(v[x][l] == v[y][l]) & 2;
+						}
+					}else{
+						std::cout << "GURU MEDITATION unknown opcode\n";
+					}
+					break;
+				case 0x06: //LD
+					for(int l = 0; l < lanes; l++){
+						v[x][l] = (v[x][l] & ~mask[l]) | (nn & mask[l]);
+					}
+					break;
+				case 0x07: //ADD
+					for(int l = 0; l < lanes; l++){
+						v[x][l] += nn & mask[l];
+					}
+					break;
+				case 0x08:
+					switch(opcode & 0x000F){
+						case 0x0: //LD
+							for(int l = 0; l < lanes; l++){
+								result[l] = v[y][l];
+							}
+							break;
+						case 0x1: //OR
+							for(int l = 0; l < lanes; l++){
+								result[l] = v[x][l] | v[y][l];
+							}
+							break;
+						case 0x2: //AND
+							for(int l = 0; l < lanes; l++){
+								result[l] = v[x][l] & v[y][l];
+							}
+							break;
+						case 0x3: //XOR
+							for(int l = 0; l < lanes; l++){
+								result[l] = v[x][l] ^ v[y][l];
+							}
+							break;
+						case 0x4: //ADD
+							for(int l = 0; l < lanes; l++){
+								flag[l] = (v[x][l] + v[y][l] >= 256);
+								result[l] = v[x][l] + v[y][l];
+							}
+							break;
+						case 0x5: //SUB
+							for(int l = 0; l < lanes; l++){
+								flag[l] = (v[x][l] >= v[y][l]);
+								result[l] = v[x][l] - v[y][l];
+							}
+							break;
+						case 0x6: //SHR
+							for(int l = 0; l < lanes; l++){
+								flag[l] = v[y][l] & 1;
+								result[l] = v[y][l] >> 1;
+							}
+							break;
+						case 0x7: //SUBN
+							for(int l = 0; l < lanes; l++){
+								flag[l] = (v[y][l] >= v[x][l]);
+								result[l] = v[y][l] - v[x][l];
+							}
+							break;
+						case 0xE: //SHL
+							for(int l = 0; l < lanes; l++){
+								flag[l] = v[y][l] >> 7;
+								result[l] = v[y][l] << 1;
+							}
+							break;
+						default:
+							std::cout << "GURU MEDITATION unknown opcode\n";
+							return;
+					}
+					for(int l = 0; l < lanes; l++){
+						v[x][l] = (v[x][l] & ~mask[l]) | (result[l] & mask[l]);
+					}
+					if((opcode & 0x000F) != 0){ //Logic ops clear VF, arithmetic sets it
+						for(int l = 0; l < lanes; l++){
+							uint8_t vf = ((opcode & 0x000F) <= 3) ? 0 : flag[l];
+							v[15][l] = (v[15][l] & ~mask[l]) | (vf & mask[l]);
+						}
+					}
+					break;
+				case 0x09: //SNE
+					if((opcode & 0x000F) == 0){
+						for(int l = 0; l < lanes; l++){
+							pc[l] += mask[l] & -(v[x][l] != v[y][l]) & 2;
+						}
+					}
+					break;
+				case 0x0A: //LD
+					for(int l = 0; l < lanes; l++){
+						i[l] = (i[l] & ~(uint16_t)(int8_t)mask[l]) | (nnn & (uint16_t)(int8_t)mask[l]);
+					}
+					break;
+				case 0x0B: //JP
+					for(int l = 0; l < lanes; l++){
+						pc[l] = (pc[l] & ~(uint16_t)(int8_t)mask[l]) | ((nnn + v[0][l]) & (uint16_t)(int8_t)mask[l]);
+					}
+					break;
+				case 0x0C: //RND
+					for(int l = 0; l < lanes; l++){
+						if(mask[l]){
+							v[x][l] = (rng[l].next() & nn);
+						}
+					}
+					break;
+				case 0x0D: //DRW
+					for(int l = 0; l < lanes; l++){
+						if(mask[l]){
+							uint8_t refA = v[x][l] & 63;
+							uint8_t refB = v[y][l] & 31;
+							bool collision = false;
+							for(int row = 0; row < (opcode & 0x000F) && (row + refB) < 32; row++){
+								uint64_t sprite = ((uint64_t)read(i[l]+row, l) << 56) >> refA;
+								collision |= (display[refB+row][l] & sprite) != 0;
+								display[refB+row][l] ^= sprite;
+							}
+							v[15][l] = collision;
+							if(displayWait){
+								live[l] = 0;
+							}
+						}
+					}
+					break;
+				case 0x0E:
+					switch(nn){
+						case 0x9E: //SKP
+							for(int l = 0; l < lanes; l++){
+								pc[l] += mask[l] & -key[v[x][l] & 0x0F][l] & 2;
+							}
+							break;
+						case 0xA1: //SKNP
+							for(int l = 0; l < lanes; l++){
+								pc[l] += mask[l] & -!key[v[x][l] & 0x0F][l] & 2;
+							}
+							break;
+						default:
+							std::cout << "GURU MEDITATION unknown opcode\n";
+							break;
+					}
+					break;
+				case 0x0F:
+					switch(nn){
+						case 0x07: //LD
+							for(int l = 0; l < lanes; l++){
+								v[x][l] = (v[x][l] & ~mask[l]) | (dt[l] & mask[l]);
+							}
+							break;
+						case 0x0A: //LD
+							for(int l = 0; l < lanes; l++){
+								if(mask[l]){
+									if(!release[l]){
+										for(int a = 0; a < 16; a++){
+											if(key[a][l]){
+												tempKey[l] = a;
+												break;
+											}
+										}
+										pc[l] -= 2;
+									}else{
+										if(tempKey[l] == 16){
+											pc[l] -= 2;
+										}else{
+											v[x][l] = tempKey[l];
+											tempKey[l] = 16;
+										}
+									}
+								}
+							}
+							break;
+						case 0x15: //LD
+							for(int l = 0; l < lanes; l++){
+								dt[l] = (dt[l] & ~mask[l]) | (v[x][l] & mask[l]);
+							}
+							break;
+						case 0x18: //LD
+							for(int l = 0; l < lanes; l++){
+								st[l] = (st[l] & ~mask[l]) | (v[x][l] & mask[l]);
+							}
+							break;
+						case 0x1E: //ADD
+							for(int l = 0; l < lanes; l++){
+								i[l] += v[x][l] & mask[l];
+							}
+							break;
+						case 0x29: //LD
+							for(int l = 0; l < lanes; l++){
+								i[l] = (i[l] & ~(uint16_t)(int8_t)mask[l]) | (((v[x][l] & 0x0F) * 5) & (uint16_t)(int8_t)mask[l]);
+							}
+							break;
+						case 0x33: //LD
+							for(int l = 0; l < lanes; l++){
+								if(mask[l]){
+									write(v[x][l] / 100, i[l], l);
+									write(v[x][l] / 10 % 10, i[l]+1, l);
+									write(v[x][l] % 10, i[l]+2, l);
+								}
+							}
+							break;
+						case 0x55: //LD
+							for(int l = 0; l < lanes; l++){
+								if(mask[l]){
+									for(int a = 0; a <= x; a++){
+										write(v[a][l], i[l], l);
+										i[l]++;
+									}
+								}
+							}
+							break;
+						case 0x65: //LD
+							for(int l = 0; l < lanes; l++){
+								if(mask[l]){
+									for(int a = 0; a <= x; a++){
+										v[a][l] = read(i[l], l);
+										i[l]++;
+									}
+								}
+							}
+							break;
+						default:
+							std::cout << "GURU MEDITATION unknown opcode\n";
+							break;
+					}
+					break;
+			}
+		}
+
+		void tick(uint32_t steps){
+			uint8_t live[lanes];
+			uint8_t pending[lanes];
+			uint8_t mask[lanes];
+			uint16_t opcode[lanes];
+			uint8_t all[lanes];
+			for(int l = 0; l < lanes; l++){
+				live[l] = 0xFF;
+				all[l] = 0xFF;
+			}
+			for(uint32_t a = 0; a < steps; a++){
+				//Fast path for the common case: every lane live, on the same pc, with the same opcode there.
+				//Lane bytes at one address sit next to each other, so this is two contiguous compares.
+				uint16_t lead = pc[0] & 4095;
+				bool uniform = true;
+				for(int l = 0; l < lanes; l++){
+					uniform &= (live[l] != 0) & (pc[l] == pc[0]) & (mem[lead][l] == mem[lead][0]) & (mem[(lead+1) & 4095][l] == mem[(lead+1) & 4095][0]);
+				}
+				if(uniform){
+					for(int l = 0; l < lanes; l++){
+						executed[l]++;
+					}
+					execute((mem[lead][0] << 8) + mem[(lead+1) & 4095][0], all, live);
+					continue;
+				}
+				bool anyLive = false;
+				for(int l = 0; l < lanes; l++){
+					opcode[l] = (mem[pc[l] & 4095][l] << 8) + mem[(pc[l]+1) & 4095][l];
+					pending[l] = live[l];
+					anyLive |= live[l];
+				}
+				if(!anyLive){
+					return;
+				}
+				int leader = 0;
+				while(true){
+					while(leader < lanes && !pending[leader]){
+						leader++;
+					}
+					if(leader == lanes){
+						break;
+					}
+					uint16_t group = opcode[leader];
+					for(int l = 0; l < lanes; l++){
+						mask[l] = pending[l] & -(opcode[l] == group);
+						pending[l] &= ~mask[l];
+						executed[l] += mask[l] & 1;
+					}
+					execute(group, mask, live);
+				}
+			}
+		}
+	};
+
+	template<int lanes>
+	class LockstepSystem{
+		//Frame loop around LockstepCpu, standing in for `lanes` Chip-8 Systems that share one ROM.
+
+		private:
+		LockstepCpu<lanes> *cpu = new LockstepCpu<lanes>;
+		uint32_t bclk = 16;
+		int audioPhase[lanes] = {};
+		float volume = 0.25;
+		bool init = false;
+
+		public:
+		LockstepSystem(int argc, std::string* args){
+			bool fileArg = false;
+			for(int a = 0; a < argc; a++){
+				if(args[a] == "-f"){
+					fileArg = true;
+					std::ifstream file(args[a+1], std::ifstream::binary);
+					if(!file.good()){
+						std::cout << "GURU MEDITATION no file\n";
+						continue;
+					}
+					std::vector<uint8_t> rom((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+					Bus bus; //Reuse the regular bus to lay out the font and ROM, then copy it to every lane
+					bus.loadROM(rom);
+					bus.setup();
+					for(int addr = 0; addr < 4096; addr++){
+						uint8_t val = bus.read(addr);
+						for(int l = 0; l < lanes; l++){
+							cpu -> mem[addr][l] = val;
+						}
+					}
+					init = true;
+				}
+				if(args[a] == "-sp"){
+					if(std::stoi(args[a+1]) < 1){
+						std::cout << "GURU MEDITATION invalid ipf setting\n";
+					}else{
+						bclk = std::stoi(args[a+1]);
+					}
+				}
+				if(args[a] == "--nodisplaywait"){
+					cpu -> displayWait = false;
+				}
+				if(args[a] == "--seed"){
+					for(int l = 0; l < lanes; l++){
+						cpu -> rng[l].reseed(std::stoull(args[a+1]) + l);
+					}
+				}
+			}
+			if(!fileArg){
+				std::cout << "GURU MEDITATION no file argument\n";
+			}
+		}
+
+		~LockstepSystem(){
+			delete cpu;
+		}
+
+		bool checkInit(){
+			return init;
+		}
+
+		void setKeys(int lane, uint16_t keys, bool release){
+			for(int a = 0; a < 16; a++){
+				cpu -> key[a][lane] = (keys >> a) & 1;
+			}
+			cpu -> release[lane] = release;
+		}
+
+		void runCycle(){
+			cpu -> tick(bclk);
+			cpu -> decTimers();
+		}
+
+		void drawLane(int lane, uint32_t *pixels){
+			for(int y = 0; y < 32; y++){
+				expandRow(cpu -> display[y][lane], pixels + y*64);
+			}
+		}
+
+		void playAudio(int lane, int16_t *samples){
+			renderTone(samples, audioPhase[lane], cpu -> st[lane] > 0, 1800, 60.0, volume);
+		}
+
+		uint64_t getInstructionCount(int lane){
+			return cpu -> executed[lane];
+		}
+	};
+}
@@ -1,15 +1,23 @@
 //Chip-8 module for MOSES. Mostly for testing UI, graphics, sound and the like.
 //Thursday 26th June, 2025
+#pragma once
 #include "../../module.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 namespace Cores::Chip8{
 	
-	struct{
+	struct Bus{
 	
 		private: 
-		uint8_t mem[4096];
+		uint8_t mem[4096] = {};
 	
 		public:
+		const uint8_t *getMemory(){ //For comparing against, not for writing behind the cache's back
+			return mem;
+		}
+		
 		void loadROM(std::vector<uint8_t> rom){
 			for(uint i = 0; i < rom.size(); i++){
 				mem[0x200+i] = rom[i];
@@ -135,14 +143,20 @@ namespace Cores::Chip8{
 				mem[addr] = val;
 			}
 		}
-	} bus;
+		
+		template<typename S>
+		void state(S &s){
+			s.field(mem);
+		}
+	};
 	
-	struct{
+	struct Cpu{
 		//Chip-8 interpreter. JIT when?
 		
 		private:
+		Bus &bus;
 		//Register definitions
-		uint8_t v[16];
+		uint8_t v[16] = {};
 		uint16_t i = 0;
 		uint16_t pc = 0x200; //Program counter
 		uint8_t sp = 0; //Stack pointer
@@ -150,17 +164,617 @@ namespace Cores::Chip8{
 		uint8_t st = 0; //Sound timer
 
 		//Variables for the interpreter
-		uint16_t curOpcode;
-		uint16_t curOpcodeMSB;
-		uint16_t stack[12];
+		uint16_t curOpcode = 0;
+		uint16_t stack[12] = {};
 		uint64_t loggedTicks = 0;
 		
+		//Predecode cache. Every address gets its opcode split into operands and a handler picked
+		//once, then tick() just jumps through the table. Entries start out (and go back to) decode,
+		//which fills them in on first use, so writes to memory only need to reset two entries.
+		//Built with MOSES_THREADED_DISPATCH, entries hold a Kind instead of a handler pointer and
+		//tick() is one function with a label per handler, each jumping straight to the next.
+		//Handlers return how many instructions they ran, which is only ever more than one for
+		//the fused kinds at the end of the enum.
+		struct Decoded;
+		typedef uint32_t (*Handler)(Cpu &cpu, const Decoded &op);
+		enum Kind:uint8_t{
+			kindDecode, kindUnknown, kindBadSuffix, kindNop, kindCLS, kindRET, kindJP, kindCALL,
+			kindSEByte, kindSNEByte, kindSEReg, kindLDByte, kindADDByte, kindLDReg, kindOR, kindAND,
+			kindXOR, kindADDReg, kindSUB, kindSHR, kindSUBN, kindSHL, kindSNEReg, kindLDI, kindJPV0,
+			kindRND, kindDRW, kindSKP, kindSKNP, kindLDVDT, kindLDK, kindLDDT, kindLDST, kindADDI,
+			kindLDF, kindLDB, kindLDStore, kindLDLoad,
+			kindLDBytePair, kindLDIDRW, kindLDILoad, kindCountLoop
+		};
+		static const int singleKinds = kindLDBytePair;
+		struct Decoded{
+			#ifdef MOSES_THREADED_DISPATCH
+			Kind kind;
+			#else
+			Handler run;
+			#endif
+			Kind single; //Just the first instruction, for when a fused kind won't fit in the frame
+			uint16_t opcode;
+			uint16_t nnn;
+			uint8_t nn;
+			uint8_t n;
+			uint8_t x;
+			uint8_t y;
+			uint8_t kk; //Only used by fused kinds
+		};
+		Decoded cache[4096] = {};
+		std::vector<uint64_t> pairCounts; //By first and second single kind, only filled in by profileTick()
+		Kind lastKind = kindDecode;
+		int lastAddr = -1;
+		bool frameDone = false; //Set by DRW when displayWait ends the frame early, or by an idle loop
+		uint8_t idleLength = 0; //Instructions in the idle loop that set frameDone, 0 for DRW
+		
+		static Kind pickKind(uint16_t opcode){
+			switch((opcode & 0xF000) >> 12){
+				case 0x00:
+					switch(opcode){
+						case 0x00E0:
+							return kindCLS;
+						case 0x00EE:
+							return kindRET;
+						default:
+							return kindUnknown;
+					}
+				case 0x01:
+					return kindJP;
+				case 0x02:
+					return kindCALL;
+				case 0x03:
+					return kindSEByte;
+				case 0x04:
+					return kindSNEByte;
+				case 0x05:
+					return ((opcode & 0x000F) == 0) ? kindSEReg : kindBadSuffix;
+				case 0x06:
+					return kindLDByte;
+				case 0x07:
+					return kindADDByte;
+				case 0x08:
+					switch(opcode & 0x000F){
+						case 0x0:
+							return kindLDReg;
+						case 0x1:
+							return kindOR;
+						case 0x2:
+							return kindAND;
+						case 0x3:
+							return kindXOR;
+						case 0x4:
+							return kindADDReg;
+						case 0x5:
+							return kindSUB;
+						case 0x6:
+							return kindSHR;
+						case 0x7:
+							return kindSUBN;
+						case 0xE:
+							return kindSHL;
+						default:
+							return kindUnknown;
+					}
+				case 0x09:
+					return ((opcode & 0x000F) == 0) ? kindSNEReg : kindNop;
+				case 0x0A:
+					return kindLDI;
+				case 0x0B:
+					return kindJPV0;
+				case 0x0C:
+					return kindRND;
+				case 0x0D:
+					return kindDRW;
+				case 0x0E:
+					switch(opcode & 0x00FF){
+						case 0x9E:
+							return kindSKP;
+						case 0xA1:
+							return kindSKNP;
+						default:
+							return kindUnknown;
+					}
+				default:
+					switch(opcode & 0x00FF){
+						case 0x07:
+							return kindLDVDT;
+						case 0x0A:
+							return kindLDK;
+						case 0x15:
+							return kindLDDT;
+						case 0x18:
+							return kindLDST;
+						case 0x1E:
+							return kindADDI;
+						case 0x29:
+							return kindLDF;
+						case 0x33:
+							return kindLDB;
+						case 0x55:
+							return kindLDStore;
+						case 0x65:
+							return kindLDLoad;
+						default:
+							return kindUnknown;
+					}
+			}
+		}
+		
+		static Handler pickHandler(Kind kind){
+			static const Handler handlers[] = {
+				opDecode, opUnknown, opBadSuffix, opNop, opCLS, opRET, opJP, opCALL,
+				opSEByte, opSNEByte, opSEReg, opLDByte, opADDByte, opLDReg, opOR, opAND,
+				opXOR, opADDReg, opSUB, opSHR, opSUBN, opSHL, opSNEReg, opLDI, opJPV0,
+				opRND, opDRW, opSKP, opSKNP, opLDVDT, opLDK, opLDDT, opLDST, opADDI,
+				opLDF, opLDB, opLDStore, opLDLoad,
+				opLDBytePair, opLDIDRW, opLDILoad, opCountLoop
+			};
+			return handlers[kind];
+		}
+		
+		static void setKind(Decoded &entry, Kind kind){
+			#ifdef MOSES_THREADED_DISPATCH
+			entry.kind = kind;
+			#else
+			entry.run = pickHandler(kind);
+			#endif
+		}
+		
+		static void clearEntry(Decoded &entry){
+			setKind(entry, kindDecode);
+			entry.single = kindDecode;
+		}
+		
+		//Superinstructions, for sequences common enough to be worth one dispatch instead of two
+		//or three. The later instructions' operands go in whichever fields the first doesn't
+		//use, so the entry still runs as just its first instruction through single.
+		Kind fuse(Decoded &entry, uint16_t addr){
+			uint16_t next = bus.readOpcode(addr+2);
+			uint16_t after = bus.readOpcode(addr+4);
+			switch(entry.single){
+				case kindLDByte: //6XNN 6YKK
+					if((next & 0xF000) == 0x6000){
+						entry.y = (next & 0x0F00) >> 8;
+						entry.kk = (next & 0x00FF);
+						return kindLDBytePair;
+					}
+					break;
+				case kindLDI:
+					if((next & 0xF000) == 0xD000){ //ANNN DXYN
+						entry.x = (next & 0x0F00) >> 8;
+						entry.y = (next & 0x00F0) >> 4;
+						entry.n = (next & 0x000F);
+						return kindLDIDRW;
+					}
+					if((next & 0xF0FF) == 0xF065){ //ANNN FX65
+						entry.x = (next & 0x0F00) >> 8;
+						return kindLDILoad;
+					}
+					break;
+				case kindADDByte: //7XNN 3XKK 1NNN, jumping back to the 7XNN
+					if((next & 0xFF00) == (0x3000 | (entry.x << 8)) && after == (0x1000 | addr)){
+						entry.kk = (next & 0x00FF);
+						entry.nnn = addr;
+						return kindCountLoop;
+					}
+					break;
+				default:
+					break;
+			}
+			return entry.single;
+		}
+		
+		static Decoded& decode(Cpu &cpu, const Decoded &op){
+			uint16_t addr = &op - cpu.cache;
+			uint16_t opcode = cpu.bus.readOpcode(addr);
+			Decoded &entry = cpu.cache[addr];
+			entry.opcode = opcode;
+			entry.nnn = (opcode & 0x0FFF);
+			entry.nn = (opcode & 0x00FF);
+			entry.n = (opcode & 0x000F);
+			entry.x = (opcode & 0x0F00) >> 8;
+			entry.y = (opcode & 0x00F0) >> 4;
+			entry.single = pickKind(opcode);
+			setKind(entry, cpu.fuse(entry, addr));
+			return entry;
+		}
+		
+		static uint32_t opDecode(Cpu &cpu, const Decoded &op){
+			Decoded &entry = decode(cpu, op);
+			return pickHandler(entry.single)(cpu, entry);
+		}
+		
+		//Loops that can't change anything until the next frame, because all they look at is the
+		//keys or the delay timer, and those only change between frames. Once one has gone around
+		//fully, the rest of the frame is skipped, leaving pc where running it out would have.
+		void idle(uint8_t length){
+			idleLength = length;
+			frameDone = true;
+		}
+		
+		//Vx := DT, then skip out on Vx == or != NN, with a jump back after. True if addr holds one
+		//and it would go around again as things stand.
+		bool isDelayLoop(uint16_t addr){
+			uint16_t load = bus.readOpcode(addr);
+			uint16_t test = bus.readOpcode(addr+2);
+			if((load & 0xF0FF) != 0xF007 || (test & 0x0F00) != (load & 0x0F00)){
+				return false;
+			}
+			uint8_t x = (load & 0x0F00) >> 8;
+			bool equal = (v[x] == (test & 0x00FF));
+			switch((test & 0xF000) >> 12){
+				case 0x03:
+					return v[x] == dt && !equal;
+				case 0x04:
+					return v[x] == dt && equal;
+				default:
+					return false;
+			}
+		}
+		
+		uint32_t endFrame(uint32_t executed, uint32_t steps){ //What tick() returns once frameDone is set
+			frameDone = false;
+			if(idleLength == 0){
+				return executed;
+			}
+			pc += ((steps - executed) % idleLength) * 2;
+			idleLength = 0;
+			return steps;
+		}
+		
+		void invalidate(uint16_t addr){
+			//Every entry starting up to five bytes earlier can cover addr, counting fused ones.
+			for(int a = 0; a < 6; a++){
+				clearEntry(cache[(addr-a) & 4095]);
+			}
+		}
+		
+		void write(uint8_t val, uint16_t addr){
+			bus.write(val, addr);
+			invalidate(addr);
+		}
+		
+		static uint32_t opUnknown(Cpu &cpu, const Decoded &op){
+			cpu.curOpcode = op.opcode;
+			std::cout << "GURU MEDITATION unknown opcode\n";
+			cpu.getDebugInfo();
+			return 1;
+		}
+		
+		static uint32_t opBadSuffix(Cpu &, const Decoded &){
+			std::cout << "GURU MEDITATION unknown opcode\n";
+			return 1;
+		}
+		
+		static uint32_t opNop(Cpu &, const Decoded &){
+			return 1;
+		}
+		
+		static uint32_t opCLS(Cpu &cpu, const Decoded &){
+			std::memset(cpu.display, 0, sizeof(cpu.display));
+			cpu.dirtyRows = ~0u;
+			return 1;
+		}
+		
+		static uint32_t opRET(Cpu &cpu, const Decoded &){
+			if(cpu.sp == 0){
+				std::cout << "GURU MEDITATION return outside of subroutine\n";
+			}else{
+				cpu.sp--;
+				cpu.pc = cpu.stack[cpu.sp];
+			}
+			return 1;
+		}
+		
+		static uint32_t opJP(Cpu &cpu, const Decoded &op){
+			if(op.nnn == cpu.pc - 2){
+				cpu.idle(1);
+			}else if(op.nnn == cpu.pc - 6 && cpu.isDelayLoop(op.nnn)){
+				cpu.idle(3);
+			}
+			cpu.pc = op.nnn;
+			return 1;
+		}
+		
+		static uint32_t opCALL(Cpu &cpu, const Decoded &op){
+			if(cpu.sp > 11){
+				std::cout << "GURU MEDITATION too many nested subroutines\n";
+			}else{
+				cpu.stack[cpu.sp] = cpu.pc;
+				cpu.sp++;
+				cpu.pc = op.nnn;
+			}
+			return 1;
+		}
+		
+		static uint32_t opSEByte(Cpu &cpu, const Decoded &op){
+			if(cpu.v[op.x] == op.nn){
+				cpu.pc+=2;
+			}
+			return 1;
+		}
+		
+		static uint32_t opSNEByte(Cpu &cpu, const Decoded &op){
+			if(cpu.v[op.x] != op.nn){
+				cpu.pc+=2;
+			}
+			return 1;
+		}
+		
+		static uint32_t opSEReg(Cpu &cpu, const Decoded &op){
+			if(cpu.v[op.x] == cpu.v[op.y]){
+				cpu.pc+=2;
+			}
+			return 1;
+		}
+		
+		static uint32_t opLDByte(Cpu &cpu, const Decoded &op){
+			cpu.v[op.x] = op.nn;
+			return 1;
+		}
+		
+		static uint32_t opADDByte(Cpu &cpu, const Decoded &op){
+			cpu.v[op.x] += op.nn;
+			return 1;
+		}
+		
+		static uint32_t opLDReg(Cpu &cpu, const Decoded &op){
+			cpu.v[op.x] = cpu.v[op.y];
+			return 1;
+		}
+		
+		static uint32_t opOR(Cpu &cpu, const Decoded &op){
+			cpu.v[op.x] |= cpu.v[op.y];
+			cpu.v[15] = false;
+			return 1;
+		}
+		
+		static uint32_t opAND(Cpu &cpu, const Decoded &op){
+			cpu.v[op.x] &= cpu.v[op.y];
+			cpu.v[15] = false;
+			return 1;
+		}
+		
+		static uint32_t opXOR(Cpu &cpu, const Decoded &op){
+			cpu.v[op.x] ^= cpu.v[op.y];
+			cpu.v[15] = false;
+			return 1;
+		}
+		
+		static uint32_t opADDReg(Cpu &cpu, const Decoded &op){
+			uint8_t flag = (cpu.v[op.x] + cpu.v[op.y] >= 256);
+			cpu.v[op.x] += cpu.v[op.y];
+			cpu.v[15] = flag;
+			return 1;
+		}
+		
+		static uint32_t opSUB(Cpu &cpu, const Decoded &op){
+			uint8_t flag = (cpu.v[op.x] >= cpu.v[op.y]);
+			cpu.v[op.x] -= cpu.v[op.y];
+			cpu.v[15] = flag;
+			return 1;
+		}
+		
+		static uint32_t opSHR(Cpu &cpu, const Decoded &op){
+			uint8_t flag = (cpu.v[op.y] & 0b00000001);
+			cpu.v[op.x] = (cpu.v[op.y] >> 1);
+			cpu.v[15] = flag;
+			return 1;
+		}
+		
+		static uint32_t opSUBN(Cpu &cpu, const Decoded &op){
+			uint8_t flag = (cpu.v[op.y] >= cpu.v[op.x]);
+			cpu.v[op.x] = (cpu.v[op.y] - cpu.v[op.x]);
+			cpu.v[15] = flag;
+			return 1;
+		}
+		
+		static uint32_t opSHL(Cpu &cpu, const Decoded &op){
+			uint8_t flag = (cpu.v[op.y] >> 7);
+			cpu.v[op.x] = (cpu.v[op.y] << 1);
+			cpu.v[15] = flag;
+			return 1;
+		}
+		
+		static uint32_t opSNEReg(Cpu &cpu, const Decoded &op){
+			if(cpu.v[op.x] != cpu.v[op.y]){
+				cpu.pc+=2;
+			}
+			return 1;
+		}
+		
+		static uint32_t opLDI(Cpu &cpu, const Decoded &op){
+			cpu.i = op.nnn;
+			return 1;
+		}
+		
+		static uint32_t opJPV0(Cpu &cpu, const Decoded &op){
+			cpu.pc = (op.nnn + cpu.v[0]);
+			return 1;
+		}
+		
+		static uint32_t opRND(Cpu &cpu, const Decoded &op){
+			cpu.v[op.x] = (cpu.rng.next() & op.nn);
+			return 1;
+		}
+		
+		static uint32_t opDRW(Cpu &cpu, const Decoded &op){
+			//A sprite row lines up with a display row in one shift. Whatever goes past column 63
+			//is shifted out, which is the clipping.
+			uint8_t refA = cpu.v[op.x] & 63;
+			uint8_t refB = cpu.v[op.y] & 31;
+			bool collision = false;
+			for(int y = 0; y < op.n && (y + refB) < 32; y++){
+				uint64_t sprite = ((uint64_t)cpu.bus.read(cpu.i+y) << 56) >> refA;
+				collision |= (cpu.display[refB+y] & sprite) != 0;
+				cpu.display[refB+y] ^= sprite;
+				cpu.dirtyRows |= 1u << (y + refB);
+			}
+			cpu.v[15] = collision;
+			cpu.frameDone = cpu.displayWait;
+			return 1;
+		}
+		
+		static uint32_t opSKP(Cpu &cpu, const Decoded &op){
+			if(cpu.key[cpu.v[op.x] & 0x0F]){
+				cpu.pc+=2;
+			}
+			return 1;
+		}
+		
+		static uint32_t opSKNP(Cpu &cpu, const Decoded &op){
+			if(!cpu.key[cpu.v[op.x] & 0x0F]){
+				cpu.pc+=2;
+			}
+			return 1;
+		}
+		
+		static uint32_t opLDVDT(Cpu &cpu, const Decoded &op){
+			cpu.v[op.x] = cpu.dt;
+			return 1;
+		}
+		
+		static uint32_t opLDK(Cpu &cpu, const Decoded &op){
+			if(!cpu.release){
+				for(int i = 0; i < 16; i++){
+					if(cpu.key[i]){
+						cpu.tempKey = i;
+						break;
+					}
+				}
+				cpu.pc-=2;
+				cpu.idle(1);
+			}else{
+				if(cpu.tempKey == 16){
+					cpu.pc-=2;
+					cpu.idle(1);
+				}else{
+					cpu.v[op.x] = cpu.tempKey;
+					cpu.tempKey = 16;
+				}
+			}
+			return 1;
+		}
+		
+		static uint32_t opLDDT(Cpu &cpu, const Decoded &op){
+			cpu.dt = cpu.v[op.x];
+			return 1;
+		}
+		
+		static uint32_t opLDST(Cpu &cpu, const Decoded &op){
+			cpu.st = cpu.v[op.x];
+			return 1;
+		}
+		
+		static uint32_t opADDI(Cpu &cpu, const Decoded &op){
+			cpu.i += cpu.v[op.x];
+			return 1;
+		}
+		
+		static uint32_t opLDF(Cpu &cpu, const Decoded &op){
+			cpu.i = (cpu.v[op.x] & 0x0F) * 5;
+			return 1;
+		}
+		
+		static uint32_t opLDB(Cpu &cpu, const Decoded &op){
+			uint8_t val = cpu.v[op.x];
+			cpu.write(val / 100, cpu.i);
+			cpu.write(val / 10 % 10, cpu.i+1);
+			cpu.write(val % 10, cpu.i+2);
+			return 1;
+		}
+		
+		static uint32_t opLDStore(Cpu &cpu, const Decoded &op){
+			for(int a = 0; a <= op.x; a++){
+				cpu.write(cpu.v[a], cpu.i);
+				cpu.i++;
+			}
+			return 1;
+		}
+		
+		static uint32_t opLDLoad(Cpu &cpu, const Decoded &op){
+			for(int a = 0; a <= op.x; a++){
+				cpu.v[a] = cpu.bus.read(cpu.i);
+				cpu.i++;
+			}
+			return 1;
+		}
+		
+		static uint32_t opLDBytePair(Cpu &cpu, const Decoded &op){
+			cpu.v[op.x] = op.nn;
+			cpu.v[op.y] = op.kk;
+			cpu.pc+=2;
+			return 2;
+		}
+		
+		static uint32_t opLDIDRW(Cpu &cpu, const Decoded &op){
+			cpu.i = op.nnn;
+			cpu.pc+=2;
+			opDRW(cpu, op);
+			return 2;
+		}
+		
+		static uint32_t opLDILoad(Cpu &cpu, const Decoded &op){
+			cpu.i = op.nnn;
+			cpu.pc+=2;
+			opLDLoad(cpu, op);
+			return 2;
+		}
+		
+		static uint32_t opCountLoop(Cpu &cpu, const Decoded &op){
+			cpu.v[op.x] += op.nn;
+			if(cpu.v[op.x] == op.kk){
+				cpu.pc+=4; //Past the skipped jump
+				return 2;
+			}
+			cpu.pc = op.nnn;
+			return 3;
+		}
+		
 		public:
-		bool key[16];
+		bool key[16] = {};
 		uint8_t tempKey = 16;
 		bool release = true;
-		bool display[64][32];
+		uint64_t display[32] = {}; //One row per word, bit 63 is the leftmost pixel
+		uint32_t dirtyRows = ~0u; //Display rows changed since the last drawFrame(), bit n is row n
 		bool displayWait = true;
+		Random rng;
+		
+		Cpu(Bus &b):bus(b){
+			flushCache();
+		}
+		
+		void flushCache(){
+			for(int a = 0; a < 4096; a++){
+				clearEntry(cache[a]);
+			}
+		}
+		
+		//Call after memory was rewritten behind the interpreter's back, like loading a state, with a
+		//copy of it from before. Only the entries over bytes that changed are thrown away.
+		void memoryReloaded(const uint8_t *before){
+			for(int a = 0; a < 4096; a++){
+				if(bus.read(a) != before[a]){
+					invalidate(a);
+				}
+			}
+		}
+		
+		template<typename S>
+		void state(S &s){
+			//Keys and release come from the frontend every frame, so they aren't saved.
+			s.field(v);
+			s.field(i);
+			s.field(pc);
+			s.field(sp);
+			s.field(dt);
+			s.field(st);
+			s.field(stack);
+			s.field(tempKey);
+			s.field(display);
+			rng.state(s);
+		}
 		
 		bool getSound(){
 			return (st > 0);
@@ -194,245 +808,253 @@ namespace Cores::Chip8{
 			}
 		}
 		
-		inline void tick(uint32_t steps){
-			uint8_t refA;
-			uint8_t refB;
-			uint8_t flagRef;
-			for(uint32_t a = 0; a < steps; a++){
-				curOpcode = bus.readOpcode(pc);
-				curOpcodeMSB = (curOpcode & 0xF000) >> 12;
-				pc+=2;
-				switch(curOpcodeMSB){
-					case 0x00:
-						switch(curOpcode){
-							case 0x00E0: //CLS
-								for(int i = 0; i < 64*32; i++){
-									display[i%64][i/64] = false;
-								}
-								break;
-							case 0x00EE: //RET
-								if(sp == 0){
-									std::cout << "GURU MEDITATION return outside of subroutine\n";
-								}else{
-									sp--;
-									pc = stack[sp];
-								}
-								break;
-							default:
-								std::cout << "GURU MEDITATION unknown opcode\n";
-								getDebugInfo();
-								break;
-						}
-						break;
-					case 0x01: //JP
-						pc = (curOpcode & 0x0FFF);
-						break;
-					case 0x02: //CALL
-						if(sp > 11){
-							std::cout << "GURU MEDITATION too many nested subroutines\n";
-						}else{
-							stack[sp] = pc;
-							sp++;
-							pc = (curOpcode & 0x0FFF);
-						}
-						break;
-					case 0x03: //SE
-						if(v[((curOpcode & 0x0F00) >> 8)] == (curOpcode & 0x00FF)){
-							pc+=2;
-						}
-						break;
-					case 0x04: //SNE
-						if(v[((curOpcode & 0x0F00) >> 8)] != (curOpcode & 0x00FF)){
-							pc+=2;
-						}
-						break;
-					case 0x05: //SE 
-						if((curOpcode & 0x000F) == 0){
-							if(v[((curOpcode & 0x0F00) >> 8)] == v[((curOpcode & 0x00F0) >> 4)]){
-								pc+=2;
-							}
-						}else{
-							std::cout << "GURU MEDITATION unknown opcode\n";
-						}
-						break;
-					case 0x06: //LD
-						v[((curOpcode & 0x0F00) >> 8)] = (curOpcode & 0x00FF);
-						break;
-					case 0x07: //ADD
-						v[((curOpcode & 0x0F00) >> 8)] += (curOpcode & 0x00FF);
-						break;
-					case 0x08: 
-						switch(curOpcode & 0x000F){
-							case 0x0: //LD
-								v[((curOpcode & 0x0F00) >> 8)] = v[((curOpcode & 0x00F0) >> 4)];
-								break;
-							case 0x1: //OR
-								v[((curOpcode & 0x0F00) >> 8)] |= v[((curOpcode & 0x00F0) >> 4)];
-								v[15] = false;
-								break;
-							case 0x2: //AND
-								v[((curOpcode & 0x0F00) >> 8)] &= v[((curOpcode & 0x00F0) >> 4)];
-								v[15] = false;
-								break;
-							case 0x3: //XOR
-								v[((curOpcode & 0x0F00) >> 8)] ^= v[((curOpcode & 0x00F0) >> 4)];
-								v[15] = false;
-								break;
-							case 0x4: //ADD
-								flagRef = (v[((curOpcode & 0x0F00) >> 8)] + v[((curOpcode & 0x00F0) >> 4)] >= 256);
-								v[((curOpcode & 0x0F00) >> 8)] += v[((curOpcode & 0x00F0) >> 4)];
-								v[15] = flagRef;
-								break;
-							case 0x5: //SUB
-								flagRef = (v[((curOpcode & 0x0F00) >> 8)] >= v[((curOpcode & 0x00F0) >> 4)]);
-								v[((curOpcode & 0x0F00) >> 8)] -= v[((curOpcode & 0x00F0) >> 4)];
-								v[15] = flagRef;
-								break;
-							case 0x6: //SHR
-								flagRef = (v[((curOpcode & 0x00F0) >> 4)] & 0b00000001);
-								v[((curOpcode & 0x0F00) >> 8)] = (v[((curOpcode & 0x00F0) >> 4)] >> 1);
-								v[15] = flagRef;
-								break;
-							case 0x7: //SUBN
-								flagRef = (v[((curOpcode & 0x00F0) >> 4)] >= v[((curOpcode & 0x0F00) >> 8)]);
-								v[((curOpcode & 0x0F00) >> 8)] = (v[((curOpcode & 0x00F0) >> 4)] - v[((curOpcode & 0x0F00) >> 8)]);
-								v[15] = flagRef;
-								break;
-							case 0xE: //SHL
-								flagRef = (v[((curOpcode & 0x00F0) >> 4)] >> 7);
-								v[((curOpcode & 0x0F00) >> 8)] = (v[((curOpcode & 0x00F0) >> 4)] << 1);
-								v[15] = flagRef;
-								break;
-							default:
-								std::cout << "GURU MEDITATION unknown opcode\n";
-								getDebugInfo();
-								break;
-						}
-						break;
-					case 0x09: //SNE
-						if((curOpcode & 0x000F) == 0){
-							if(v[((curOpcode & 0x0F00) >> 8)] != v[((curOpcode & 0x00F0) >> 4)]){
-								pc+=2;
-							}
-						}
-						break;
-					case 0x0A: //LD
-						i = (curOpcode & 0x0FFF);
-						break;
-					case 0x0B: //JP
-						pc = ((curOpcode & 0x0FFF) + v[0]);
-						break;
-					case 0x0C: //RND
-						v[((curOpcode & 0x0F00) >> 8)] = (rand() & (curOpcode & 0x00FF));
-						break;
-					case 0x0D: //DRW
-						refA = v[((curOpcode & 0x0F00) >> 8)] & 63;
-						refB = v[((curOpcode & 0x00F0) >> 4)] & 31;
-						v[15] = false;
-						for(int y = 0; y < (curOpcode & 0x000F); y++){
-							if((y + refB) > 31){
-								break;
-							}
-							flagRef = bus.read(i+y);
-							for(int x = 0; x < 8; x++){
-								if((x + refA) > 63){
-									break;
-								}
-								if(flagRef & (0b10000000 >> x) && display[(refA+x)][(refB+y)]){
-									v[15] = true;
-								}
-								display[(refA+x)][(refB+y)] ^= (flagRef & (0b10000000 >> x)) >> (7-x);
-							}
-						}
-						if(displayWait){
-							return;
-						}
-						break;
-					case 0x0E:
-						switch((curOpcode & 0x00FF)){
-							case 0x9E: //SKP
-								if(key[v[((curOpcode & 0x0F00) >> 8)] & 0x0F]){
-									pc+=2;
-								}
-							break;
-							case 0xA1: //SKNP
-								if(!key[v[((curOpcode & 0x0F00) >> 8)] & 0x0F]){
-									pc+=2;
-								}
-							break;
-							default:
-								std::cout << "GURU MEDITATION unknown opcode\n";
-								getDebugInfo();
-							break;
-						}
-						break;
-					case 0x0F:
-						switch(curOpcode & 0x00FF){
-							case 0x07: //LD
-								v[(curOpcode & 0x0F00) >> 8] = dt;
-								break;
-							case 0x0A: //LD
-								if(!release){
-									for(int i = 0; i < 16; i++){
-										if(key[i]){
-											tempKey = i;
-											break;
-										}
-									}
-									pc-=2;
-								}else{
-									if(tempKey == 16){
-										pc-=2;
-									}else{
-										v[((curOpcode & 0x0F00) >> 8)] = tempKey;
-										tempKey = 16;
-									}
-								}
-								break;
-							case 0x15: //LD
-								dt = v[((curOpcode & 0x0F00) >> 8)];
-								break;
-							case 0x18: //LD
-								st = v[((curOpcode & 0x0F00) >> 8)];
-								break;
-							case 0x1E: //ADD
-								i += v[((curOpcode & 0x0F00) >> 8)];
-								break;
-							case 0x29: //LD
-								i = (v[((curOpcode & 0x0F00) >> 8)] & 0x0F) * 5;
-								break;
-							case 0x33: //LD
-								refA = v[((curOpcode & 0x0F00) >> 8)];
-								bus.write(refA / 100, i);
-								bus.write(refA / 10 % 10, i+1);
-								bus.write(refA % 10, i+2);
-								break;
-							case 0x55: //LD
-								for(int a = 0; a <= ((curOpcode & 0x0F00) >> 8); a++){
-									bus.write(v[a], i);
-									i++;
-								}
-								break;
-							case 0x65: //LD
-								for(int a = 0; a <= ((curOpcode & 0x0F00) >> 8); a++){
-									v[a] = bus.read(i);
-									i++;
-								}
-								break;
-							default:
-								std::cout << "GURU MEDITATION unknown opcode\n";
-								getDebugInfo();
-								break;
-						}
-						break;
-						default:
-							std::cout << "GURU MEDITATION unknown opcode\n";
-							getDebugInfo();
-							break;
+		//Counts which instruction follows which, for picking what to fuse. Only pairs next to each
+		//other in memory count, since those are the only ones a fused entry could cover.
+		uint32_t profileTick(uint32_t steps){ //Same contract as tick(), one instruction at a time
+			if(pairCounts.empty()){
+				pairCounts.resize(singleKinds*singleKinds);
+			}
+			uint32_t a = 0;
+			while(a < steps){
+				uint16_t addr = pc & 4095;
+				Kind kind = pickKind(bus.readOpcode(addr));
+				if(addr == lastAddr + 2){
+					pairCounts[lastKind*singleKinds + kind]++;
+				}
+				lastKind = kind;
+				lastAddr = addr;
+				a += tick(1);
+				if(kind == kindDRW && displayWait){ //Ends the frame, like it would in tick()
+					break;
 				}
 			}
+			return a;
 		}
 		
+		void writeProfile(std::string fileName){
+			static const char *const patterns[] = {
+				"", "????", "5XYN", "9XYN", "00E0", "00EE", "1NNN", "2NNN",
+				"3XNN", "4XNN", "5XY0", "6XNN", "7XNN", "8XY0", "8XY1", "8XY2",
+				"8XY3", "8XY4", "8XY5", "8XY6", "8XY7", "8XYE", "9XY0", "ANNN", "BNNN",
+				"CXNN", "DXYN", "EX9E", "EXA1", "FX07", "FX0A", "FX15", "FX18", "FX1E",
+				"FX29", "FX33", "FX55", "FX65"
+			};
+			nlohmann::json pairs = nlohmann::json::array();
+			for(size_t a = 0; a < pairCounts.size(); a++){
+				if(pairCounts[a] == 0){
+					continue;
+				}
+				pairs.push_back({{"first", patterns[a / singleKinds]}, {"second", patterns[a % singleKinds]}, {"count", pairCounts[a]}});
+			}
+			nlohmann::json profile;
+			profile["pairs"] = pairs;
+			std::ofstream out(fileName, std::ios_base::trunc);
+			out << profile.dump(1, '\t') << "\n";
+		}
+		
+		#ifdef MOSES_THREADED_DISPATCH
+		inline uint32_t tick(uint32_t steps){ //Returns the number of instructions executed
+			//Labels-as-values version of the loop below. Every handler ends in its own indirect
+			//jump, so the branch predictor gets a history per handler instead of one shared jump.
+			static void *const labels[] = {
+				&&doDecode, &&doUnknown, &&doBadSuffix, &&doNop, &&doCLS, &&doRET, &&doJP, &&doCALL,
+				&&doSEByte, &&doSNEByte, &&doSEReg, &&doLDByte, &&doADDByte, &&doLDReg, &&doOR, &&doAND,
+				&&doXOR, &&doADDReg, &&doSUB, &&doSHR, &&doSUBN, &&doSHL, &&doSNEReg, &&doLDI, &&doJPV0,
+				&&doRND, &&doDRW, &&doSKP, &&doSKNP, &&doLDVDT, &&doLDK, &&doLDDT, &&doLDST, &&doADDI,
+				&&doLDF, &&doLDB, &&doLDStore, &&doLDLoad,
+				&&doLDBytePair, &&doLDIDRW, &&doLDILoad, &&doCountLoop
+			};
+			const Decoded *op = &cache[pc & 4095];
+			uint32_t a = 0;
+			#define CHIP8_NEXT() \
+				if(a == steps){ \
+					goto done; \
+				} \
+				a++; \
+				op = &cache[pc & 4095]; \
+				pc+=2; \
+				goto *labels[op -> kind]
+			CHIP8_NEXT();
+			doDecode:
+				decode(*this, *op);
+				goto *labels[op -> kind];
+			doUnknown:
+				opUnknown(*this, *op);
+				CHIP8_NEXT();
+			doBadSuffix:
+				opBadSuffix(*this, *op);
+				CHIP8_NEXT();
+			doNop:
+				opNop(*this, *op);
+				CHIP8_NEXT();
+			doCLS:
+				opCLS(*this, *op);
+				CHIP8_NEXT();
+			doRET:
+				opRET(*this, *op);
+				CHIP8_NEXT();
+			doJP:
+				opJP(*this, *op);
+				if(frameDone){
+					curOpcode = op -> opcode;
+					return endFrame(a, steps);
+				}
+				CHIP8_NEXT();
+			doCALL:
+				opCALL(*this, *op);
+				CHIP8_NEXT();
+			doSEByte:
+				opSEByte(*this, *op);
+				CHIP8_NEXT();
+			doSNEByte:
+				opSNEByte(*this, *op);
+				CHIP8_NEXT();
+			doSEReg:
+				opSEReg(*this, *op);
+				CHIP8_NEXT();
+			doLDByte:
+				opLDByte(*this, *op);
+				CHIP8_NEXT();
+			doADDByte:
+				opADDByte(*this, *op);
+				CHIP8_NEXT();
+			doLDReg:
+				opLDReg(*this, *op);
+				CHIP8_NEXT();
+			doOR:
+				opOR(*this, *op);
+				CHIP8_NEXT();
+			doAND:
+				opAND(*this, *op);
+				CHIP8_NEXT();
+			doXOR:
+				opXOR(*this, *op);
+				CHIP8_NEXT();
+			doADDReg:
+				opADDReg(*this, *op);
+				CHIP8_NEXT();
+			doSUB:
+				opSUB(*this, *op);
+				CHIP8_NEXT();
+			doSHR:
+				opSHR(*this, *op);
+				CHIP8_NEXT();
+			doSUBN:
+				opSUBN(*this, *op);
+				CHIP8_NEXT();
+			doSHL:
+				opSHL(*this, *op);
+				CHIP8_NEXT();
+			doSNEReg:
+				opSNEReg(*this, *op);
+				CHIP8_NEXT();
+			doLDI:
+				opLDI(*this, *op);
+				CHIP8_NEXT();
+			doJPV0:
+				opJPV0(*this, *op);
+				CHIP8_NEXT();
+			doRND:
+				opRND(*this, *op);
+				CHIP8_NEXT();
+			doDRW:
+				opDRW(*this, *op);
+				if(frameDone){
+					curOpcode = op -> opcode;
+					return endFrame(a, steps);
+				}
+				CHIP8_NEXT();
+			doSKP:
+				opSKP(*this, *op);
+				CHIP8_NEXT();
+			doSKNP:
+				opSKNP(*this, *op);
+				CHIP8_NEXT();
+			doLDVDT:
+				opLDVDT(*this, *op);
+				CHIP8_NEXT();
+			doLDK:
+				opLDK(*this, *op);
+				if(frameDone){
+					curOpcode = op -> opcode;
+					return endFrame(a, steps);
+				}
+				CHIP8_NEXT();
+			doLDDT:
+				opLDDT(*this, *op);
+				CHIP8_NEXT();
+			doLDST:
+				opLDST(*this, *op);
+				CHIP8_NEXT();
+			doADDI:
+				opADDI(*this, *op);
+				CHIP8_NEXT();
+			doLDF:
+				opLDF(*this, *op);
+				CHIP8_NEXT();
+			doLDB:
+				opLDB(*this, *op);
+				CHIP8_NEXT();
+			doLDStore:
+				opLDStore(*this, *op);
+				CHIP8_NEXT();
+			doLDLoad:
+				opLDLoad(*this, *op);
+				CHIP8_NEXT();
+			//Fused kinds go back to their first instruction alone when the rest won't fit.
+			//a has already counted the first one.
+			doLDBytePair:
+				if(steps - a < 1){
+					goto *labels[op -> single];
+				}
+				a += opLDBytePair(*this, *op) - 1;
+				CHIP8_NEXT();
+			doLDIDRW:
+				if(steps - a < 1){
+					goto *labels[op -> single];
+				}
+				a += opLDIDRW(*this, *op) - 1;
+				if(frameDone){
+					curOpcode = op -> opcode;
+					return endFrame(a, steps);
+				}
+				CHIP8_NEXT();
+			doLDILoad:
+				if(steps - a < 1){
+					goto *labels[op -> single];
+				}
+				a += opLDILoad(*this, *op) - 1;
+				CHIP8_NEXT();
+			doCountLoop:
+				if(steps - a < 2){
+					goto *labels[op -> single];
+				}
+				a += opCountLoop(*this, *op) - 1;
+				CHIP8_NEXT();
+			done:
+			#undef CHIP8_NEXT
+			curOpcode = op -> opcode;
+			return steps;
+		}
+		#else
+		inline uint32_t tick(uint32_t steps){ //Returns the number of instructions executed
+			const Decoded *op = &cache[pc & 4095];
+			uint32_t a = 0;
+			while(a < steps){
+				op = &cache[pc & 4095];
+				pc+=2;
+				//Fused kinds run up to three instructions, so the last two of a frame go singly
+				a += (steps - a >= 3) ? op -> run(*this, *op) : pickHandler(op -> single)(*this, *op);
+				if(frameDone){
+					curOpcode = op -> opcode;
+					return endFrame(a, steps);
+				}
+			}
+			curOpcode = op -> opcode; //Only the debugger looks at it, so it isn't kept up per instruction
+			return steps;
+		}
+		#endif
+
 		inline std::string loggedTick(uint32_t steps){
 			std::stringstream ret;
 			for(int a = 0; a < steps; a++){
@@ -473,22 +1095,67 @@ namespace Cores::Chip8{
 			}
 			return ret.str();
 		}
-	} cpu;
+	};
 
+	inline void expandRow(uint64_t row, uint32_t *pixels){
+		//Turns a display row into 64 white or black pixels, shared with the lockstep engine.
+		#ifdef __SSE2__
+		const __m128i bits = _mm_set_epi32(1, 2, 4, 8); //Leftmost pixel of four in the lowest lane
+		const __m128i black = _mm_set1_epi32(0xFF000000);
+		for(int x = 0; x < 64; x += 4){
+			__m128i nibble = _mm_set1_epi32((row >> (60 - x)) & 0x0F);
+			__m128i lit = _mm_cmpeq_epi32(_mm_and_si128(nibble, bits), bits);
+			_mm_storeu_si128((__m128i*)(pixels + x), _mm_or_si128(lit, black));
+		}
+		#else
+		for(int x = 0; x < 64; x++){
+			pixels[x] = ((row << x) >> 63) ? 0xFFFFFFFF : 0xFF000000;
+		}
+		#endif
+	}
+	
+	inline void renderTone(int16_t *samples, int &phase, bool sound, uint32_t sampleFreq, double targetFPS, float volume){
+		//440Hz beep while the sound timer runs, shared with the lockstep engine.
+		const float freq = 440 * 2 * M_PI;
+		phase %= sampleFreq;
+		if(sound){
+			for(int i = phase; i < (phase + (sampleFreq/targetFPS)); i++){
+				double time = i/(double)sampleFreq;
+				samples[(i-phase)] = std::sin(freq*time)*(volume * 32767);
+			}
+			phase += (sampleFreq/targetFPS);
+		}else{
+			for(int i = 0; i < (sampleFreq/targetFPS); i++){
+				samples[i] = 0;
+			}
+			phase = 0;
+		}
+	}
+	
 	class System:public Module{
 		private:
-		float freq = 440 * 2 * M_PI;
+		static const uint16_t stateVersion = 3; //Bump whenever the state() field lists change
+		Bus bus;
+		Cpu cpu{bus};
+		std::string profileFile; //Empty unless --profile-opcodes was given
+		uint64_t profileFrames = 0;
+		uint8_t previousMem[4096]; //What loadState() compares against
+		uint64_t previousDisplay[32];
 		
 		void drawFrame(){
 			for(int y = 0; y < 32; y++){
-				for(int x = 0; x < 64; x++){
-					if(cpu.display[x][y]){
-						frameBuffer[((y*64)+x)] = 0xFFFFFFFF;
-					}else{
-						frameBuffer[((y*64)+x)] = 0xFF000000;
-					}
+				if((cpu.dirtyRows >> y) & 1){
+					frameBuffer.markRows(y, 1);
 				}
 			}
+			cpu.dirtyRows = 0;
+			for(int y = 0; y < 32; y++){
+				if(!frameBuffer.isStale(y)){
+					continue;
+				}
+				expandRow(cpu.display[y], &frameBuffer[y*64]);
+			}
+			frameBuffer.publish();
 		}
 		
 		void getKey() override{
@@ -513,28 +1180,50 @@ namespace Cores::Chip8{
 		public:
 		
 		int16_t* playAudio() override{
-			uint32_t sampleFreq = winArgs -> getSampleFrequency();
-			double targetFPS = winArgs -> getFPS();
-			audioPhase %= sampleFreq;
-			if(cpu.getSound()){
-				for(int i = audioPhase; i < (audioPhase + (sampleFreq/targetFPS)); i++){
-					double time = i/(double)sampleFreq;
-					audioSamples[(i-audioPhase)] = std::sin(freq*time)*(volume * 32767);
-				}
-				audioPhase += (sampleFreq/targetFPS);
-			}else{
-				for(int i = 0; i < (sampleFreq/targetFPS); i++){
-					audioSamples[i] = 0;
+			renderTone(audioSamples, audioPhase, cpu.getSound(), winArgs -> getSampleFrequency(), winArgs -> getFPS(), volume);
+			return audioSamples;
+		}
+		
+		template<typename S>
+		void state(S &s){
+			bus.state(s);
+			cpu.state(s);
+		}
+		
+		size_t saveState(uint8_t *buffer, size_t size) override{
+			return writeState(*this, stateVersion, buffer, size);
+		}
+		
+		bool loadState(const uint8_t *buffer, size_t size) override{
+			//Runahead and rewind load a state every frame, and most of it matches what's already
+			//there. Only the cache entries and display rows that actually differ get thrown away.
+			std::memcpy(previousMem, bus.getMemory(), sizeof(previousMem));
+			std::memcpy(previousDisplay, cpu.display, sizeof(previousDisplay));
+			bool ret = readState(*this, stateVersion, buffer, size);
+			cpu.memoryReloaded(previousMem);
+			for(int y = 0; y < 32; y++){
+				if(cpu.display[y] != previousDisplay[y]){
+					cpu.dirtyRows |= 1u << y;
 				}
-				audioPhase = 0;
 			}
-			return audioSamples;
+			return ret;
+		}
+		
+		size_t getStateSize() override{
+			return measureState(*this);
 		}
 		
 		void runCycle() override{
 			getKey();
 			cpu.release = keyRelease;
-			cpu.tick(bclk);
+			if(profileFile.empty()){
+				instructionCount += cpu.tick(bclk);
+			}else{
+				instructionCount += cpu.profileTick(bclk);
+				if(++profileFrames % 60 == 0){ //Rewritten every second, since there's no telling when MOSES gets closed
+					cpu.writeProfile(profileFile);
+				}
+			}
 			drawFrame();
 			cpu.decTimers();
 		}
@@ -553,7 +1242,8 @@ namespace Cores::Chip8{
 		}
 		
 		System(int argc, std::string* args):Module("Chip-8", 16, 64, 32, 1, 1800, 60.0){
-			frameBuffer.resize(64*32);
+			frameBuffer.resize(64, 32);
+			frameBuffer.trackRows();
 			bool fileArg = false;
 			for(int i = 0; i < argc; i++){
 				if(args[i] == "-f"){
@@ -570,6 +1260,12 @@ namespace Cores::Chip8{
 				if(args[i] == "--nodisplaywait"){
 					cpu.displayWait = false;
 				}
+				if(args[i] == "--profile-opcodes"){
+					profileFile = args[i+1];
+				}
+				if(args[i] == "--seed"){
+					cpu.rng.reseed(std::stoull(args[i+1]));
+				}
 			}
 			if(!fileArg){
 				std::cout << "GURU MEDITATION no file argument\n";
@@ -0,0 +1,81 @@
+//Page table memory map for the 6502 machines' buses.
+//Saturday 17th of October, 2026
+#pragma once
+
+class MemoryMap{
+	//One entry per 256 byte page. A page is either memory, read and written straight through a host
+	//pointer, or I/O, which goes to a handler. Plain memory costs a table lookup and a dereference,
+	//and mirroring, bank switching or a language card is just pointing entries somewhere else.
+	
+	public:
+	typedef uint8_t (*ReadHandler)(void *context, uint16_t addr);
+	typedef void (*WriteHandler)(void *context, uint8_t val, uint16_t addr);
+	
+	private:
+	uint8_t *readPages[256];
+	uint8_t *writePages[256];
+	ReadHandler readHandlers[256] = {};
+	WriteHandler writeHandlers[256] = {};
+	void *contexts[256] = {};
+	uint8_t blank[256] = {}; //What unmapped pages read as
+	uint8_t sink[256] = {}; //Where writes to ROM and unmapped pages go
+	
+	public:
+	MemoryMap(){
+		unmap(0x00, 256);
+	}
+	
+	//Pages point into the owning bus's memory and handlers get the bus as their context, so a copy
+	//would still read and write the original machine.
+	MemoryMap(const MemoryMap&) = delete;
+	MemoryMap& operator=(const MemoryMap&) = delete;
+	
+	//Maps pages onwards from first to memory, which is repeated as often as needed to fill them,
+	//so RAM smaller than the range is mirrored. Size has to be a multiple of 256. Writes to
+	//memory that isn't writable are dropped.
+	void mapMemory(uint8_t first, int count, uint8_t *memory, size_t size, bool writable){
+		for(int a = 0; a < count; a++){
+			uint8_t *page = memory + (a*256) % size;
+			readPages[first + a] = page;
+			writePages[first + a] = writable ? page : sink;
+		}
+	}
+	
+	void mapIo(uint8_t first, int count, ReadHandler read, WriteHandler write, void *context){
+		for(int a = 0; a < count; a++){
+			readPages[first + a] = nullptr;
+			writePages[first + a] = nullptr;
+			readHandlers[first + a] = read;
+			writeHandlers[first + a] = write;
+			contexts[first + a] = context;
+		}
+	}
+	
+	void unmap(uint8_t first, int count){
+		for(int a = 0; a < count; a++){
+			readPages[first + a] = blank;
+			writePages[first + a] = sink;
+		}
+	}
+	
+	bool isIo(uint16_t addr){
+		return readPages[addr >> 8] == nullptr;
+	}
+	
+	uint8_t read(uint16_t addr){
+		uint8_t *page = readPages[addr >> 8];
+		if(page != nullptr){
+			return page[addr & 0xFF];
+		}
+		return readHandlers[addr >> 8](contexts[addr >> 8], addr);
+	}
+	
+	void write(uint8_t val, uint16_t addr){
+		uint8_t *page = writePages[addr >> 8];
+		if(page != nullptr){
+			page[addr & 0xFF] = val;
+			return;
+		}
+		writeHandlers[addr >> 8](contexts[addr >> 8], val, addr);
+	}
+};
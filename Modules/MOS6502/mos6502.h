@@ -0,0 +1,1214 @@
+//MOS 6502 interpreter for MOSES. Planned support: Atari 2600, NES, Apple II, Atari 800, etc.
+//Every machine shares this one core. The bus is a template parameter so its reads and writes
+//inline, and the differences between chips come from the Variant parameter.
+//Friday 20th of June, 2025
+#pragma once
+
+namespace Mos6502Variants{
+	//What sets the chips apart, checked with if constexpr so a variant pays nothing for what it
+	//doesn't have. The 2A03 is an NMOS 6502 with the decimal adder cut out, so both share the
+	//undocumented opcodes. A 65C02 would add its own flags here.
+	
+	struct Nmos{
+		static constexpr bool decimalMode = true;
+	};
+	
+	struct Ricoh2a03{ //NES
+		static constexpr bool decimalMode = false;
+	};
+}
+
+namespace Mos6502Microcode{
+	//Every opcode is an operation plus an addressing mode. At compile time those are expanded into
+	//the bus steps the chip takes on each cycle after the opcode fetch, so the core only has to look
+	//up and run one step per cycle. Reading steps[] for an opcode gives its bus activity cycle by
+	//cycle, as laid out in the usual 6502 timing documents.
+	
+	enum Op:uint8_t{
+		opNOP, opORA, opAND, opEOR, opADC, opSBC, opCMP, opCPX, opCPY, opBIT,
+		opLDA, opLDX, opLDY, opSTA, opSTX, opSTY,
+		opASL, opLSR, opROL, opROR, opINC, opDEC,
+		opINX, opINY, opDEX, opDEY, opTAX, opTAY, opTXA, opTYA, opTSX, opTXS,
+		opCLC, opSEC, opCLI, opSEI, opCLV, opCLD, opSED,
+		opBPL, opBMI, opBVC, opBVS, opBCC, opBCS, opBNE, opBEQ,
+		//Undocumented. The unstable ones report themselves instead of guessing at what a given chip
+		//does, but keep their timing: XAA and LXA as reads, AHX, SHX, SHY and TAS as stores.
+		opSLO, opRLA, opSRE, opRRA, opDCP, opISC, opSAX, opLAX, opLAS,
+		opANC, opALR, opARR, opAXS, opUnstable, opUnstableStore
+	};
+	
+	enum Mode:uint8_t{
+		modeImplied, modeAccumulator, modeImmediate,
+		modeZeroPage, modeZeroPageX, modeZeroPageY,
+		modeAbsolute, modeAbsoluteX, modeAbsoluteY,
+		modeIndirectX, modeIndirectY, modeRelative,
+		modeJMP, modeJMPIndirect, modeJSR, modeRTS, modeRTI, modeBRK,
+		modePHA, modePHP, modePLA, modePLP, modeJAM
+	};
+	
+	enum Step:uint8_t{
+		stepImplied, //Dummy read of pc, then the operation on registers
+		stepAccumulator, //Dummy read of pc, then the operation on A
+		stepImmediate, //Operand from pc, then the operation
+		stepFetchDummy, //Dummy read of pc, pc++
+		stepPcDummy, //Dummy read of pc
+		stepZeroPage, //Address from pc
+		stepZeroPageX, //Dummy read of the address, then X added within page zero
+		stepZeroPageY,
+		stepAbsoluteLow, //Address low byte from pc
+		stepAbsoluteHigh, //Address high byte from pc
+		stepAbsoluteHighX, //Address high byte from pc, then X added to the low byte only
+		stepAbsoluteHighY,
+		stepPointer, //Page zero pointer from pc
+		stepPointerX, //Dummy read of the pointer, then X added to it
+		stepPointerLow, //Address low byte from the pointer
+		stepPointerHigh, //Address high byte from the pointer + 1
+		stepPointerHighY, //Address high byte from the pointer + 1, then Y added to the low byte only
+		stepReadIndexed, //Operand from the unfixed address. Done here unless a page was crossed
+		stepFixAddress, //Dummy read of the unfixed address, then the high byte fixed
+		stepRead, //Operand from the address, then the operation
+		stepWrite, //The operation, then its result to the address
+		stepReadModify, //Operand from the address
+		stepModify, //Operand written back unchanged, then the operation
+		stepWriteModified, //Result to the address
+		stepBranch, //Offset from pc. Done here unless the branch is taken
+		stepBranchTake, //Dummy read of pc, then the offset added to its low byte. Done unless a page was crossed
+		stepBranchFix, //Dummy read of pc, then its high byte fixed
+		stepJump, //pc high byte from pc, low byte from the address
+		stepIndirectLow, //pc low byte from the address, latched
+		stepIndirectJump, //pc high byte from the address + 1, without carrying into the high byte
+		stepStackDummy, //Dummy read of the stack
+		stepStackIncrement, //Dummy read of the stack, then sp++
+		stepPushPCH,
+		stepPushPCL,
+		stepPushA,
+		stepPushSR, //With B set
+		stepPushBreak, //With B set, then I set
+		stepPullPCL, //Then sp++
+		stepPullPCH,
+		stepPullSRNext, //Then sp++
+		stepPullSR,
+		stepPullA,
+		stepIncrementPc, //Dummy read of pc, pc++
+		stepVectorLow,
+		stepVectorHigh,
+		stepJam,
+		stepLast = 0x80 //Set on the final step of every opcode
+	};
+	
+	struct Opcode{
+		Op op;
+		Mode mode;
+	};
+	
+	constexpr Opcode opcodes[256] = {
+		//0x00
+		{opNOP, modeBRK}, {opORA, modeIndirectX}, {opNOP, modeJAM}, {opSLO, modeIndirectX},
+		{opNOP, modeZeroPage}, {opORA, modeZeroPage}, {opASL, modeZeroPage}, {opSLO, modeZeroPage},
+		{opNOP, modePHP}, {opORA, modeImmediate}, {opASL, modeAccumulator}, {opANC, modeImmediate},
+		{opNOP, modeAbsolute}, {opORA, modeAbsolute}, {opASL, modeAbsolute}, {opSLO, modeAbsolute},
+		//0x10
+		{opBPL, modeRelative}, {opORA, modeIndirectY}, {opNOP, modeJAM}, {opSLO, modeIndirectY},
+		{opNOP, modeZeroPageX}, {opORA, modeZeroPageX}, {opASL, modeZeroPageX}, {opSLO, modeZeroPageX},
+		{opCLC, modeImplied}, {opORA, modeAbsoluteY}, {opNOP, modeImplied}, {opSLO, modeAbsoluteY},
+		{opNOP, modeAbsoluteX}, {opORA, modeAbsoluteX}, {opASL, modeAbsoluteX}, {opSLO, modeAbsoluteX},
+		//0x20
+		{opNOP, modeJSR}, {opAND, modeIndirectX}, {opNOP, modeJAM}, {opRLA, modeIndirectX},
+		{opBIT, modeZeroPage}, {opAND, modeZeroPage}, {opROL, modeZeroPage}, {opRLA, modeZeroPage},
+		{opNOP, modePLP}, {opAND, modeImmediate}, {opROL, modeAccumulator}, {opANC, modeImmediate},
+		{opBIT, modeAbsolute}, {opAND, modeAbsolute}, {opROL, modeAbsolute}, {opRLA, modeAbsolute},
+		//0x30
+		{opBMI, modeRelative}, {opAND, modeIndirectY}, {opNOP, modeJAM}, {opRLA, modeIndirectY},
+		{opNOP, modeZeroPageX}, {opAND, modeZeroPageX}, {opROL, modeZeroPageX}, {opRLA, modeZeroPageX},
+		{opSEC, modeImplied}, {opAND, modeAbsoluteY}, {opNOP, modeImplied}, {opRLA, modeAbsoluteY},
+		{opNOP, modeAbsoluteX}, {opAND, modeAbsoluteX}, {opROL, modeAbsoluteX}, {opRLA, modeAbsoluteX},
+		//0x40
+		{opNOP, modeRTI}, {opEOR, modeIndirectX}, {opNOP, modeJAM}, {opSRE, modeIndirectX},
+		{opNOP, modeZeroPage}, {opEOR, modeZeroPage}, {opLSR, modeZeroPage}, {opSRE, modeZeroPage},
+		{opNOP, modePHA}, {opEOR, modeImmediate}, {opLSR, modeAccumulator}, {opALR, modeImmediate},
+		{opNOP, modeJMP}, {opEOR, modeAbsolute}, {opLSR, modeAbsolute}, {opSRE, modeAbsolute},
+		//0x50
+		{opBVC, modeRelative}, {opEOR, modeIndirectY}, {opNOP, modeJAM}, {opSRE, modeIndirectY},
+		{opNOP, modeZeroPageX}, {opEOR, modeZeroPageX}, {opLSR, modeZeroPageX}, {opSRE, modeZeroPageX},
+		{opCLI, modeImplied}, {opEOR, modeAbsoluteY}, {opNOP, modeImplied}, {opSRE, modeAbsoluteY},
+		{opNOP, modeAbsoluteX}, {opEOR, modeAbsoluteX}, {opLSR, modeAbsoluteX}, {opSRE, modeAbsoluteX},
+		//0x60
+		{opNOP, modeRTS}, {opADC, modeIndirectX}, {opNOP, modeJAM}, {opRRA, modeIndirectX},
+		{opNOP, modeZeroPage}, {opADC, modeZeroPage}, {opROR, modeZeroPage}, {opRRA, modeZeroPage},
+		{opNOP, modePLA}, {opADC, modeImmediate}, {opROR, modeAccumulator}, {opARR, modeImmediate},
+		{opNOP, modeJMPIndirect}, {opADC, modeAbsolute}, {opROR, modeAbsolute}, {opRRA, modeAbsolute},
+		//0x70
+		{opBVS, modeRelative}, {opADC, modeIndirectY}, {opNOP, modeJAM}, {opRRA, modeIndirectY},
+		{opNOP, modeZeroPageX}, {opADC, modeZeroPageX}, {opROR, modeZeroPageX}, {opRRA, modeZeroPageX},
+		{opSEI, modeImplied}, {opADC, modeAbsoluteY}, {opNOP, modeImplied}, {opRRA, modeAbsoluteY},
+		{opNOP, modeAbsoluteX}, {opADC, modeAbsoluteX}, {opROR, modeAbsoluteX}, {opRRA, modeAbsoluteX},
+		//0x80
+		{opNOP, modeImmediate}, {opSTA, modeIndirectX}, {opNOP, modeImmediate}, {opSAX, modeIndirectX},
+		{opSTY, modeZeroPage}, {opSTA, modeZeroPage}, {opSTX, modeZeroPage}, {opSAX, modeZeroPage},
+		{opDEY, modeImplied}, {opNOP, modeImmediate}, {opTXA, modeImplied}, {opUnstable, modeImmediate},
+		{opSTY, modeAbsolute}, {opSTA, modeAbsolute}, {opSTX, modeAbsolute}, {opSAX, modeAbsolute},
+		//0x90
+		{opBCC, modeRelative}, {opSTA, modeIndirectY}, {opNOP, modeJAM}, {opUnstableStore, modeIndirectY},
+		{opSTY, modeZeroPageX}, {opSTA, modeZeroPageX}, {opSTX, modeZeroPageY}, {opSAX, modeZeroPageY},
+		{opTYA, modeImplied}, {opSTA, modeAbsoluteY}, {opTXS, modeImplied}, {opUnstableStore, modeAbsoluteY},
+		{opUnstableStore, modeAbsoluteX}, {opSTA, modeAbsoluteX}, {opUnstableStore, modeAbsoluteY}, {opUnstableStore, modeAbsoluteY},
+		//0xA0
+		{opLDY, modeImmediate}, {opLDA, modeIndirectX}, {opLDX, modeImmediate}, {opLAX, modeIndirectX},
+		{opLDY, modeZeroPage}, {opLDA, modeZeroPage}, {opLDX, modeZeroPage}, {opLAX, modeZeroPage},
+		{opTAY, modeImplied}, {opLDA, modeImmediate}, {opTAX, modeImplied}, {opUnstable, modeImmediate},
+		{opLDY, modeAbsolute}, {opLDA, modeAbsolute}, {opLDX, modeAbsolute}, {opLAX, modeAbsolute},
+		//0xB0
+		{opBCS, modeRelative}, {opLDA, modeIndirectY}, {opNOP, modeJAM}, {opLAX, modeIndirectY},
+		{opLDY, modeZeroPageX}, {opLDA, modeZeroPageX}, {opLDX, modeZeroPageY}, {opLAX, modeZeroPageY},
+		{opCLV, modeImplied}, {opLDA, modeAbsoluteY}, {opTSX, modeImplied}, {opLAS, modeAbsoluteY},
+		{opLDY, modeAbsoluteX}, {opLDA, modeAbsoluteX}, {opLDX, modeAbsoluteY}, {opLAX, modeAbsoluteY},
+		//0xC0
+		{opCPY, modeImmediate}, {opCMP, modeIndirectX}, {opNOP, modeImmediate}, {opDCP, modeIndirectX},
+		{opCPY, modeZeroPage}, {opCMP, modeZeroPage}, {opDEC, modeZeroPage}, {opDCP, modeZeroPage},
+		{opINY, modeImplied}, {opCMP, modeImmediate}, {opDEX, modeImplied}, {opAXS, modeImmediate},
+		{opCPY, modeAbsolute}, {opCMP, modeAbsolute}, {opDEC, modeAbsolute}, {opDCP, modeAbsolute},
+		//0xD0
+		{opBNE, modeRelative}, {opCMP, modeIndirectY}, {opNOP, modeJAM}, {opDCP, modeIndirectY},
+		{opNOP, modeZeroPageX}, {opCMP, modeZeroPageX}, {opDEC, modeZeroPageX}, {opDCP, modeZeroPageX},
+		{opCLD, modeImplied}, {opCMP, modeAbsoluteY}, {opNOP, modeImplied}, {opDCP, modeAbsoluteY},
+		{opNOP, modeAbsoluteX}, {opCMP, modeAbsoluteX}, {opDEC, modeAbsoluteX}, {opDCP, modeAbsoluteX},
+		//0xE0
+		{opCPX, modeImmediate}, {opSBC, modeIndirectX}, {opNOP, modeImmediate}, {opISC, modeIndirectX},
+		{opCPX, modeZeroPage}, {opSBC, modeZeroPage}, {opINC, modeZeroPage}, {opISC, modeZeroPage},
+		{opINX, modeImplied}, {opSBC, modeImmediate}, {opNOP, modeImplied}, {opSBC, modeImmediate},
+		{opCPX, modeAbsolute}, {opSBC, modeAbsolute}, {opINC, modeAbsolute}, {opISC, modeAbsolute},
+		//0xF0
+		{opBEQ, modeRelative}, {opSBC, modeIndirectY}, {opNOP, modeJAM}, {opISC, modeIndirectY},
+		{opNOP, modeZeroPageX}, {opSBC, modeZeroPageX}, {opINC, modeZeroPageX}, {opISC, modeZeroPageX},
+		{opSED, modeImplied}, {opSBC, modeAbsoluteY}, {opNOP, modeImplied}, {opISC, modeAbsoluteY},
+		{opNOP, modeAbsoluteX}, {opSBC, modeAbsoluteX}, {opINC, modeAbsoluteX}, {opISC, modeAbsoluteX}
+	};
+	
+	enum Access:uint8_t{
+		accessRead,
+		accessWrite,
+		accessModify
+	};
+	
+	constexpr Access getAccess(Op op){
+		switch(op){
+			case opSTA: case opSTX: case opSTY: case opSAX: case opUnstableStore:
+				return accessWrite;
+			case opASL: case opLSR: case opROL: case opROR: case opINC: case opDEC:
+			case opSLO: case opRLA: case opSRE: case opRRA: case opDCP: case opISC:
+				return accessModify;
+			default:
+				return accessRead;
+		}
+	}
+	
+	static const int maxSteps = 7; //(zp,X) and (zp),Y read-modify-writes
+	
+	struct Table{
+		uint8_t steps[256][maxSteps] = {};
+		Op ops[256] = {};
+		Mode modes[256] = {};
+		Access accesses[256] = {};
+		uint8_t cycles[256] = {}; //Including the fetch, page crossing and taken branch
+	};
+	
+	struct Builder{
+		uint8_t *steps;
+		int count;
+		Access access;
+		
+		constexpr void add(Step step){
+			steps[count++] = step;
+		}
+		
+		constexpr void finalAccess(){ //From a known address to the end of the instruction
+			switch(access){
+				case accessRead:
+					add(stepRead);
+					break;
+				case accessWrite:
+					add(stepWrite);
+					break;
+				case accessModify:
+					add(stepReadModify);
+					add(stepModify);
+					add(stepWriteModified);
+					break;
+			}
+		}
+		
+		constexpr void indexedAccess(){ //Reads only pay for the fixup cycle when a page is crossed
+			if(access == accessRead){
+				add(stepReadIndexed);
+				add(stepRead);
+			}else{
+				add(stepFixAddress);
+				finalAccess();
+			}
+		}
+		
+		constexpr void build(Mode mode){
+			switch(mode){
+				case modeImplied:
+					add(stepImplied);
+					break;
+				case modeAccumulator:
+					add(stepAccumulator);
+					break;
+				case modeImmediate:
+					add(stepImmediate);
+					break;
+				case modeZeroPage:
+					add(stepZeroPage);
+					finalAccess();
+					break;
+				case modeZeroPageX:
+					add(stepZeroPage);
+					add(stepZeroPageX);
+					finalAccess();
+					break;
+				case modeZeroPageY:
+					add(stepZeroPage);
+					add(stepZeroPageY);
+					finalAccess();
+					break;
+				case modeAbsolute:
+					add(stepAbsoluteLow);
+					add(stepAbsoluteHigh);
+					finalAccess();
+					break;
+				case modeAbsoluteX:
+					add(stepAbsoluteLow);
+					add(stepAbsoluteHighX);
+					indexedAccess();
+					break;
+				case modeAbsoluteY:
+					add(stepAbsoluteLow);
+					add(stepAbsoluteHighY);
+					indexedAccess();
+					break;
+				case modeIndirectX:
+					add(stepPointer);
+					add(stepPointerX);
+					add(stepPointerLow);
+					add(stepPointerHigh);
+					finalAccess();
+					break;
+				case modeIndirectY:
+					add(stepPointer);
+					add(stepPointerLow);
+					add(stepPointerHighY);
+					indexedAccess();
+					break;
+				case modeRelative:
+					add(stepBranch);
+					add(stepBranchTake);
+					add(stepBranchFix);
+					break;
+				case modeJMP:
+					add(stepAbsoluteLow);
+					add(stepJump);
+					break;
+				case modeJMPIndirect:
+					add(stepAbsoluteLow);
+					add(stepAbsoluteHigh);
+					add(stepIndirectLow);
+					add(stepIndirectJump);
+					break;
+				case modeJSR:
+					add(stepAbsoluteLow);
+					add(stepStackDummy);
+					add(stepPushPCH);
+					add(stepPushPCL);
+					add(stepJump);
+					break;
+				case modeRTS:
+					add(stepPcDummy);
+					add(stepStackIncrement);
+					add(stepPullPCL);
+					add(stepPullPCH);
+					add(stepIncrementPc);
+					break;
+				case modeRTI:
+					add(stepPcDummy);
+					add(stepStackIncrement);
+					add(stepPullSRNext);
+					add(stepPullPCL);
+					add(stepPullPCH);
+					break;
+				case modeBRK:
+					add(stepFetchDummy);
+					add(stepPushPCH);
+					add(stepPushPCL);
+					add(stepPushBreak);
+					add(stepVectorLow);
+					add(stepVectorHigh);
+					break;
+				case modePHA:
+					add(stepPcDummy);
+					add(stepPushA);
+					break;
+				case modePHP:
+					add(stepPcDummy);
+					add(stepPushSR);
+					break;
+				case modePLA:
+					add(stepPcDummy);
+					add(stepStackIncrement);
+					add(stepPullA);
+					break;
+				case modePLP:
+					add(stepPcDummy);
+					add(stepStackIncrement);
+					add(stepPullSR);
+					break;
+				case modeJAM:
+					add(stepJam);
+					break;
+			}
+			steps[count - 1] |= stepLast;
+		}
+	};
+	
+	constexpr Table buildTable(){
+		Table ret{};
+		for(int a = 0; a < 256; a++){
+			ret.ops[a] = opcodes[a].op;
+			ret.modes[a] = opcodes[a].mode;
+			ret.accesses[a] = getAccess(opcodes[a].op);
+			Builder builder{ret.steps[a], 0, ret.accesses[a]};
+			builder.build(opcodes[a].mode);
+			ret.cycles[a] = builder.count + 1;
+		}
+		return ret;
+	}
+	
+	inline constexpr Table table = buildTable();
+}
+
+template<typename Bus, typename Variant>
+class Mos6502{
+	
+	private:
+	Bus &bus;
+	//Register definitions
+	uint8_t a = 0; //Accumulator
+	uint8_t sr = 32; //Status register. Only I, D, B and the unused bit are kept here, see getStatus()
+	//N, Z, C and V are kept as what they came from, and only worked out when something reads them
+	uint8_t negative = 0; //N is bit 7 of this
+	uint8_t zero = 1; //Z is set when this is 0
+	bool carry = false;
+	uint8_t overflow[3] = {}; //The two addends and the sum of the last add, V comes from their signs
+	uint8_t sp = 0; //Stack pointer
+	uint8_t x = 0; //Index register
+	uint8_t y = 0; //Index register
+	uint16_t pc = 0;
+	
+	//Other variables for the interpreter to remember CPU state
+	uint8_t extraTicks = 0; //Which step of the opcode's microcode runs next
+	uint8_t curOpcode;
+	uint16_t stackOffset;
+	bool newCycle = true;
+	uint8_t dummy; //This is where we put dummy reads and writes. Should never be used.
+	//Carried between the steps of an instruction
+	uint16_t address = 0;
+	uint8_t pointer = 0;
+	uint8_t data = 0;
+	bool crossed = false; //The indexed address or branch target is on another page
+	
+	__attribute__((always_inline))
+	inline void setFlag(char flag, bool set){ //Shorthand for setting flags
+		switch(flag){
+			case 'n':
+				negative = set ? 0b10000000 : 0;
+			break;
+			case 'v':
+				overflow[0] = 0;
+				overflow[1] = 0;
+				overflow[2] = set ? 0b10000000 : 0;
+			break;
+			case 'b':
+				set ? sr |= 0b00010000 : sr &= 0b11101111;
+			break;
+			case 'd':
+				set ? sr |= 0b00001000 : sr &= 0b11110111;
+			break;
+			case 'i':
+				set ? sr |= 0b00000100 : sr &= 0b11111011;
+			break;
+			case 'z':
+				zero = !set;
+			break;
+			case 'c':
+				carry = set;
+			break;
+		}
+	}
+	
+	__attribute__((always_inline))
+	inline bool getFlag(char flag){
+		switch(flag){
+			case 'n':
+				return negative >> 7;
+			break;
+			case 'v':
+				return (~(overflow[0] ^ overflow[1]) & (overflow[0] ^ overflow[2])) >> 7;
+			break;
+			case 'b':
+				return ((sr & 0b00010000) >> 4);
+			break;
+			case 'd':
+				return ((sr & 0b00001000) >> 3);
+			break;
+			case 'i':
+				return ((sr & 0b00000100) >> 2);
+			break;
+			case 'z':
+				return zero == 0;
+			break;
+			case 'c':
+				return carry;
+			break;
+		}
+		return false;
+	}
+	
+	void setStatus(uint8_t val){ //B and the unused bit don't exist in the register
+		sr = (val & 0b00001100) | 0b00100000;
+		setFlag('n', val & 0b10000000);
+		setFlag('v', val & 0b01000000);
+		setFlag('z', val & 0b00000010);
+		setFlag('c', val & 0b00000001);
+	}
+	
+	void finish(){
+		newCycle = true;
+		extraTicks = 0;
+	}
+	
+	void illegalOpcode(){ //The JAM opcodes, which lock up a real chip
+		std::cout << "GURU MEDITATION illegal opcode";
+		finish();
+	}
+	
+	__attribute__((always_inline))
+	inline void setResultFlags(uint8_t val){
+		negative = val;
+		zero = val;
+	}
+	
+	void addBinary(uint8_t val){ //A + M + C, setting every flag
+		uint16_t sum = a + val + getFlag('c');
+		overflow[0] = a;
+		overflow[1] = val;
+		overflow[2] = sum;
+		setFlag('c', sum > 0xFF);
+		a = sum;
+		setResultFlags(a);
+	}
+	
+	void adc(uint8_t val){
+		if constexpr(Variant::decimalMode){
+			if(getFlag('d')){
+				//NMOS takes Z from the binary sum, and N and V from the sum before its high digit is adjusted
+				uint8_t low = (a & 0x0F) + (val & 0x0F) + getFlag('c');
+				if(low > 9){
+					low += 6;
+				}
+				uint8_t high = (a >> 4) + (val >> 4) + (low > 0x0F);
+				uint8_t partial = (high << 4) | (low & 0x0F);
+				setFlag('z', ((a + val + getFlag('c')) & 0xFF) == 0);
+				setFlag('n', partial & 0b10000000);
+				overflow[0] = a;
+				overflow[1] = val;
+				overflow[2] = partial;
+				if(high > 9){
+					high += 6;
+				}
+				setFlag('c', high > 0x0F);
+				a = (high << 4) | (low & 0x0F);
+				return;
+			}
+		}
+		addBinary(val);
+	}
+	
+	void sbc(uint8_t val){
+		if constexpr(Variant::decimalMode){
+			if(getFlag('d')){
+				//NMOS sets every flag as if the subtraction was binary
+				int low = (a & 0x0F) - (val & 0x0F) - !getFlag('c');
+				int high = (a >> 4) - (val >> 4);
+				if(low < 0){
+					low -= 6;
+					high--;
+				}
+				if(high < 0){
+					high -= 6;
+				}
+				uint8_t result = (high << 4) | (low & 0x0F);
+				addBinary(~val);
+				a = result;
+				return;
+			}
+		}
+		addBinary(~val);
+	}
+	
+	void compare(uint8_t reg, uint8_t val){
+		setFlag('c', reg >= val);
+		setResultFlags(reg - val);
+	}
+	
+	void index(uint16_t base, uint8_t offset){ //Adds to the low byte only, the high byte is fixed a cycle later
+		uint16_t fixed = base + offset;
+		crossed = (fixed ^ base) & 0xFF00;
+		address = (base & 0xFF00) | (fixed & 0x00FF);
+	}
+	
+	void push(uint8_t val){
+		bus.write(val, stackOffset + sp);
+		sp--;
+	}
+	
+	uint8_t pull(){
+		return bus.read(stackOffset + sp);
+	}
+	
+	void pullStatus(){
+		setStatus(pull());
+	}
+	
+	__attribute__((always_inline))
+	inline bool branchTaken(uint8_t op){
+		using namespace Mos6502Microcode;
+		switch(op){
+			case opBPL:
+				return !getFlag('n');
+			case opBMI:
+				return getFlag('n');
+			case opBVC:
+				return !getFlag('v');
+			case opBVS:
+				return getFlag('v');
+			case opBCC:
+				return !getFlag('c');
+			case opBCS:
+				return getFlag('c');
+			case opBNE:
+				return !getFlag('z');
+			case opBEQ:
+				return getFlag('z');
+		}
+		return false;
+	}
+	
+	//The ALU half of an instruction. Works on data, which holds the operand on the way in and the
+	//value to store on the way out for writes and read-modify-writes. Always inlined, so the fast
+	//path's per-opcode functions, which pass a constant, are left with only their own operation.
+	__attribute__((always_inline))
+	inline void operate(uint8_t op){
+		using namespace Mos6502Microcode;
+		switch(op){
+			case opNOP:
+				break;
+			case opORA:
+				a |= data;
+				setResultFlags(a);
+				break;
+			case opAND:
+				a &= data;
+				setResultFlags(a);
+				break;
+			case opEOR:
+				a ^= data;
+				setResultFlags(a);
+				break;
+			case opADC:
+				adc(data);
+				break;
+			case opSBC:
+				sbc(data);
+				break;
+			case opCMP:
+				compare(a, data);
+				break;
+			case opCPX:
+				compare(x, data);
+				break;
+			case opCPY:
+				compare(y, data);
+				break;
+			case opBIT:
+				zero = a & data;
+				negative = data;
+				setFlag('v', data & 0b01000000);
+				break;
+			case opLDA:
+				a = data;
+				setResultFlags(a);
+				break;
+			case opLDX:
+				x = data;
+				setResultFlags(x);
+				break;
+			case opLDY:
+				y = data;
+				setResultFlags(y);
+				break;
+			case opSTA:
+				data = a;
+				break;
+			case opSTX:
+				data = x;
+				break;
+			case opSTY:
+				data = y;
+				break;
+			case opASL:
+				setFlag('c', data & 0b10000000);
+				data <<= 1;
+				setResultFlags(data);
+				break;
+			case opLSR:
+				setFlag('c', data & 0b00000001);
+				data >>= 1;
+				setResultFlags(data);
+				break;
+			case opROL:{
+				uint8_t carry = getFlag('c');
+				setFlag('c', data & 0b10000000);
+				data = (data << 1) | carry;
+				setResultFlags(data);
+				break;
+			}
+			case opROR:{
+				uint8_t carry = getFlag('c');
+				setFlag('c', data & 0b00000001);
+				data = (data >> 1) | (carry << 7);
+				setResultFlags(data);
+				break;
+			}
+			case opINC:
+				data++;
+				setResultFlags(data);
+				break;
+			case opDEC:
+				data--;
+				setResultFlags(data);
+				break;
+			case opINX:
+				x++;
+				setResultFlags(x);
+				break;
+			case opINY:
+				y++;
+				setResultFlags(y);
+				break;
+			case opDEX:
+				x--;
+				setResultFlags(x);
+				break;
+			case opDEY:
+				y--;
+				setResultFlags(y);
+				break;
+			case opTAX:
+				x = a;
+				setResultFlags(x);
+				break;
+			case opTAY:
+				y = a;
+				setResultFlags(y);
+				break;
+			case opTXA:
+				a = x;
+				setResultFlags(a);
+				break;
+			case opTYA:
+				a = y;
+				setResultFlags(a);
+				break;
+			case opTSX:
+				x = sp;
+				setResultFlags(x);
+				break;
+			case opTXS:
+				sp = x;
+				break;
+			case opCLC:
+				setFlag('c', false);
+				break;
+			case opSEC:
+				setFlag('c', true);
+				break;
+			case opCLI:
+				setFlag('i', false);
+				break;
+			case opSEI:
+				setFlag('i', true);
+				break;
+			case opCLV:
+				setFlag('v', false);
+				break;
+			case opCLD:
+				setFlag('d', false);
+				break;
+			case opSED:
+				setFlag('d', true);
+				break;
+			case opSLO:
+				execute(opASL);
+				execute(opORA);
+				break;
+			case opRLA:
+				execute(opROL);
+				execute(opAND);
+				break;
+			case opSRE:
+				execute(opLSR);
+				execute(opEOR);
+				break;
+			case opRRA:
+				execute(opROR);
+				adc(data);
+				break;
+			case opDCP:
+				data--;
+				compare(a, data);
+				break;
+			case opISC:
+				data++;
+				sbc(data);
+				break;
+			case opSAX:
+				data = a & x;
+				break;
+			case opLAX:
+				a = data;
+				x = data;
+				setResultFlags(a);
+				break;
+			case opLAS:
+				sp &= data;
+				a = sp;
+				x = sp;
+				setResultFlags(a);
+				break;
+			case opANC:
+				execute(opAND);
+				setFlag('c', a & 0b10000000);
+				break;
+			case opALR:
+				a &= data;
+				setFlag('c', a & 0b00000001);
+				a >>= 1;
+				setResultFlags(a);
+				break;
+			case opARR: //Binary behaviour only, the NMOS decimal quirks aren't modelled
+				a &= data;
+				a = (a >> 1) | (getFlag('c') << 7);
+				setResultFlags(a);
+				setFlag('c', a & 0b01000000);
+				setFlag('v', ((a >> 6) ^ (a >> 5)) & 1);
+				break;
+			case opAXS:{
+				uint8_t masked = a & x;
+				setFlag('c', masked >= data);
+				x = masked - data;
+				setResultFlags(x);
+				break;
+			}
+			case opUnstable:
+				std::cout << "GURU MEDITATION unstable opcode";
+				break;
+			case opUnstableStore:
+				data = a & x; //Stands in for what gets stored, which depends on the chip
+				std::cout << "GURU MEDITATION unstable opcode";
+				break;
+		}
+	}
+	
+	void execute(uint8_t op){
+		operate(op);
+	}
+	
+	//Runs one cycle's worth of an instruction after its opcode fetch.
+	void runStep(uint8_t step, uint8_t op){
+		using namespace Mos6502Microcode;
+		switch(step){
+			case stepImplied:
+				dummy = bus.read(pc); //Dummy read. We have to do it anyway to know when the bus is busy.
+				execute(op);
+				break;
+			case stepAccumulator:
+				dummy = bus.read(pc);
+				data = a;
+				execute(op);
+				a = data;
+				break;
+			case stepImmediate:
+				data = bus.read(pc);
+				pc++;
+				execute(op);
+				break;
+			case stepFetchDummy:
+				dummy = bus.read(pc);
+				pc++;
+				break;
+			case stepPcDummy:
+				dummy = bus.read(pc);
+				break;
+			case stepZeroPage:
+				address = bus.read(pc);
+				pc++;
+				break;
+			case stepZeroPageX:
+				dummy = bus.read(address);
+				address = (address + x) & 0xFF;
+				break;
+			case stepZeroPageY:
+				dummy = bus.read(address);
+				address = (address + y) & 0xFF;
+				break;
+			case stepAbsoluteLow:
+				address = bus.read(pc);
+				pc++;
+				break;
+			case stepAbsoluteHigh:
+				address |= bus.read(pc) << 8;
+				pc++;
+				break;
+			case stepAbsoluteHighX:
+				index(address | (bus.read(pc) << 8), x);
+				pc++;
+				break;
+			case stepAbsoluteHighY:
+				index(address | (bus.read(pc) << 8), y);
+				pc++;
+				break;
+			case stepPointer:
+				pointer = bus.read(pc);
+				pc++;
+				break;
+			case stepPointerX:
+				dummy = bus.read(pointer);
+				pointer += x;
+				break;
+			case stepPointerLow:
+				address = bus.read(pointer);
+				break;
+			case stepPointerHigh:
+				address |= bus.read((uint8_t)(pointer + 1)) << 8;
+				break;
+			case stepPointerHighY:
+				index(address | (bus.read((uint8_t)(pointer + 1)) << 8), y);
+				break;
+			case stepReadIndexed:
+				data = bus.read(address);
+				if(crossed){
+					address += 0x100;
+				}else{
+					execute(op);
+					finish();
+				}
+				break;
+			case stepFixAddress:
+				dummy = bus.read(address);
+				if(crossed){
+					address += 0x100;
+				}
+				break;
+			case stepRead:
+				data = bus.read(address);
+				execute(op);
+				break;
+			case stepWrite:
+				execute(op);
+				bus.write(data, address);
+				break;
+			case stepReadModify:
+				data = bus.read(address);
+				break;
+			case stepModify:
+				bus.write(data, address);
+				execute(op);
+				break;
+			case stepWriteModified:
+				bus.write(data, address);
+				break;
+			case stepBranch:
+				data = bus.read(pc);
+				pc++;
+				if(!branchTaken(op)){
+					finish();
+				}
+				break;
+			case stepBranchTake:
+				dummy = bus.read(pc);
+				address = pc + (int8_t)data;
+				crossed = (address ^ pc) & 0xFF00;
+				pc = (pc & 0xFF00) | (address & 0x00FF);
+				if(!crossed){
+					finish();
+				}
+				break;
+			case stepBranchFix:
+				dummy = bus.read(pc);
+				pc = address;
+				break;
+			case stepJump:
+				pc = address | (bus.read(pc) << 8);
+				break;
+			case stepIndirectLow:
+				data = bus.read(address);
+				break;
+			case stepIndirectJump: //The pointer's high byte doesn't carry, so JMP ($xxFF) wraps within its page
+				pc = data | (bus.read((address & 0xFF00) | ((address + 1) & 0x00FF)) << 8);
+				break;
+			case stepStackDummy:
+				dummy = pull();
+				break;
+			case stepStackIncrement:
+				dummy = pull();
+				sp++;
+				break;
+			case stepPushPCH:
+				push(pc >> 8);
+				break;
+			case stepPushPCL:
+				push(pc & 0xFF);
+				break;
+			case stepPushA:
+				push(a);
+				break;
+			case stepPushSR:
+				push(getStatus() | 0b00010000);
+				break;
+			case stepPushBreak:
+				push(getStatus() | 0b00010000);
+				setFlag('i', true);
+				break;
+			case stepPullPCL:
+				pc = (pc & 0xFF00) | pull();
+				sp++;
+				break;
+			case stepPullPCH:
+				pc = (pc & 0x00FF) | (pull() << 8);
+				break;
+			case stepPullSRNext:
+				pullStatus();
+				sp++;
+				break;
+			case stepPullSR:
+				pullStatus();
+				break;
+			case stepPullA:
+				a = pull();
+				setResultFlags(a);
+				break;
+			case stepIncrementPc:
+				dummy = bus.read(pc);
+				pc++;
+				break;
+			case stepVectorLow:
+				pc = (pc & 0xFF00) | bus.read(0xFFFE);
+				break;
+			case stepVectorHigh:
+				pc = (pc & 0x00FF) | (bus.read(0xFFFF) << 8);
+				break;
+			case stepJam:
+				illegalOpcode();
+				break;
+		}
+	}
+	
+	//The fast path, one function per opcode so that its mode, access and operation are all known at
+	//compile time. Dummy reads and the unchanged write back of a read-modify-write are left out, as
+	//only timed addresses can tell they happened.
+	template<uint8_t Opcode>
+	uint8_t access(uint16_t target, uint16_t next, uint8_t cycles){
+		using namespace Mos6502Microcode;
+		constexpr uint8_t op = table.ops[Opcode];
+		if(bus.timed(target)){
+			return 0;
+		}
+		pc = next;
+		if constexpr(table.accesses[Opcode] == accessRead){
+			data = bus.read(target);
+			operate(op);
+		}else if constexpr(table.accesses[Opcode] == accessWrite){
+			operate(op);
+			bus.write(data, target);
+		}else{
+			data = bus.read(target);
+			operate(op);
+			bus.write(data, target);
+		}
+		return cycles;
+	}
+	
+	template<uint8_t Opcode>
+	uint8_t indexedAccess(uint16_t base, uint8_t offset, uint16_t next){
+		using namespace Mos6502Microcode;
+		constexpr uint8_t cycles = table.cycles[Opcode];
+		uint16_t target = base + offset;
+		uint16_t unfixed = (base & 0xFF00) | (target & 0x00FF);
+		if constexpr(table.accesses[Opcode] == accessRead){
+			if(target == unfixed){
+				return access<Opcode>(target, next, cycles - 1);
+			}
+		}
+		if(bus.timed(unfixed)){ //Dummy read
+			return 0;
+		}
+		return access<Opcode>(target, next, cycles);
+	}
+	
+	template<uint8_t Opcode>
+	uint8_t run(){
+		using namespace Mos6502Microcode;
+		constexpr Mode mode = table.modes[Opcode];
+		constexpr uint8_t op = table.ops[Opcode];
+		constexpr uint8_t cycles = table.cycles[Opcode];
+		uint16_t operand = pc + 1;
+		if constexpr(mode == modeImplied){
+			pc = operand;
+			operate(op);
+			return cycles;
+		}else if constexpr(mode == modeAccumulator){
+			pc = operand;
+			data = a;
+			operate(op);
+			a = data;
+			return cycles;
+		}else if constexpr(mode == modeImmediate){
+			pc = operand + 1;
+			data = bus.read(operand);
+			operate(op);
+			return cycles;
+		}else if constexpr(mode == modeZeroPage){
+			return access<Opcode>(bus.read(operand), operand + 1, cycles);
+		}else if constexpr(mode == modeZeroPageX){
+			return access<Opcode>((bus.read(operand) + x) & 0xFF, operand + 1, cycles);
+		}else if constexpr(mode == modeZeroPageY){
+			return access<Opcode>((bus.read(operand) + y) & 0xFF, operand + 1, cycles);
+		}else if constexpr(mode == modeAbsolute){
+			return access<Opcode>(bus.read(operand) | (bus.read(operand + 1) << 8), operand + 2, cycles);
+		}else if constexpr(mode == modeAbsoluteX){
+			return indexedAccess<Opcode>(bus.read(operand) | (bus.read(operand + 1) << 8), x, operand + 2);
+		}else if constexpr(mode == modeAbsoluteY){
+			return indexedAccess<Opcode>(bus.read(operand) | (bus.read(operand + 1) << 8), y, operand + 2);
+		}else if constexpr(mode == modeIndirectX){
+			uint8_t zp = bus.read(operand) + x;
+			return access<Opcode>(bus.read(zp) | (bus.read((uint8_t)(zp + 1)) << 8), operand + 1, cycles);
+		}else if constexpr(mode == modeIndirectY){
+			uint8_t zp = bus.read(operand);
+			return indexedAccess<Opcode>(bus.read(zp) | (bus.read((uint8_t)(zp + 1)) << 8), y, operand + 1);
+		}else if constexpr(mode == modeRelative){
+			uint16_t next = operand + 1;
+			if(!branchTaken(op)){
+				pc = next;
+				return cycles - 2;
+			}
+			uint16_t target = next + (int8_t)bus.read(operand);
+			uint16_t unfixed = (next & 0xFF00) | (target & 0x00FF);
+			if(target == unfixed){
+				pc = target;
+				return cycles - 1;
+			}
+			if(bus.timed(unfixed)){ //Dummy read
+				return 0;
+			}
+			pc = target;
+			return cycles;
+		}else if constexpr(mode == modeJMP){
+			pc = bus.read(operand) | (bus.read(operand + 1) << 8);
+			return cycles;
+		}else if constexpr(mode == modeJMPIndirect){
+			uint16_t low = bus.read(operand) | (bus.read(operand + 1) << 8);
+			uint16_t high = (low & 0xFF00) | ((low + 1) & 0x00FF);
+			if(bus.timed(low) || bus.timed(high)){
+				return 0;
+			}
+			pc = bus.read(low) | (bus.read(high) << 8);
+			return cycles;
+		}else{ //The stack and JAM, through the microcode back to back
+			if constexpr(mode == modeRTS){ //Its last cycle is a dummy read at the pulled address
+				uint16_t target = bus.read(stackOffset + (uint8_t)(sp + 1)) | (bus.read(stackOffset + (uint8_t)(sp + 2)) << 8);
+				if(bus.timed(target)){
+					return 0;
+				}
+			}
+			pc = operand;
+			curOpcode = Opcode;
+			newCycle = false;
+			uint8_t ret = 1;
+			do{
+				tick(1);
+				ret++;
+			}while(!newCycle);
+			return ret;
+		}
+	}
+	
+	template<uint8_t Opcode>
+	static uint8_t handler(Mos6502 &cpu){
+		return cpu.run<Opcode>();
+	}
+	
+	typedef uint8_t (*Handler)(Mos6502 &cpu);
+	
+	struct Handlers{
+		Handler entries[256];
+	};
+	
+	template<size_t... Opcodes>
+	static constexpr Handlers makeHandlers(std::index_sequence<Opcodes...>){
+		return {{&handler<Opcodes>...}};
+	}
+	
+	public:
+	Mos6502(Bus &b, uint16_t stack):bus(b){
+		stackOffset = stack;
+	}
+	
+	void tick(uint32_t steps){ //Runs steps clock cycles. Every cycle is one step from the microcode table.
+		using namespace Mos6502Microcode;
+		for(uint32_t i = 0; i < steps; i++){
+			if(newCycle){
+				curOpcode = bus.read(pc);
+				pc++;
+				newCycle = false;
+				continue;
+			}
+			uint8_t step = table.steps[curOpcode][extraTicks];
+			extraTicks++;
+			runStep(step & ~stepLast, table.ops[curOpcode]);
+			if(step & stepLast){
+				finish();
+			}
+		}
+	}
+	
+	uint8_t getStatus(){ //The whole status register, as PHP would push it but with B clear
+		return (sr & 0b00001100) | 0b00100000 | (negative & 0b10000000) | (getFlag('v') << 6) | (getFlag('z') << 1) | carry;
+	}
+	
+	bool atBoundary(){ //Between instructions
+		return newCycle;
+	}
+	
+	//Runs a whole instruction in one call and returns the cycles it took. If any of its accesses,
+	//dummy ones included, would land on an address the bus reports as timed, it returns 0 having
+	//changed nothing, and the caller steps the instruction with tick() instead so other chips can
+	//be caught up to the exact cycle. Page zero, the stack and the vectors are taken to never be
+	//timed.
+	uint8_t instruction(){
+		static constexpr Handlers handlers = makeHandlers(std::make_index_sequence<256>());
+		if(!newCycle || bus.timed(pc) || bus.timed(pc + 2)){
+			return 0;
+		}
+		return handlers.entries[bus.read(pc)](*this);
+	}
+};
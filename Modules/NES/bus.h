@@ -1,14 +1,38 @@
 //NES bus emulation
 #pragma once
+#include "../MOS6502/memorymap.h"
 
-struct{
-	uint8_t mem[2048];
+namespace Cores::Nes{
 	
-	uint8_t read(uint16_t addr){
-		return mem[addr];
-	}
-	
-	void write(int8_t val, uint16_t addr){
-		mem[addr] = val;
-	}
-} bus;
+	struct Bus{
+		uint8_t mem[2048] = {};
+		MemoryMap map;
+		
+		//The PPU and APU registers aren't emulated yet, so they read as 0 and ignore writes
+		static uint8_t readRegister(void *, uint16_t){
+			return 0;
+		}
+		
+		static void writeRegister(void *, uint8_t, uint16_t){}
+		
+		Bus(){
+			map.mapMemory(0x00, 0x20, mem, sizeof(mem), true); //2KB of RAM mirrored four times
+			map.mapIo(0x20, 0x20, readRegister, writeRegister, this); //PPU, mirrored every 8 bytes
+			map.mapIo(0x40, 0x01, readRegister, writeRegister, this); //APU and I/O, and the rest of their page
+			//Cartridge space stays unmapped until there are mappers
+		}
+		
+		//I/O pages, where the exact cycle of an access matters
+		bool timed(uint16_t addr){
+			return map.isIo(addr);
+		}
+		
+		uint8_t read(uint16_t addr){
+			return map.read(addr);
+		}
+		
+		void write(int8_t val, uint16_t addr){
+			map.write(val, addr);
+		}
+	};
+}
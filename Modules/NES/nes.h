@@ -3,12 +3,18 @@
 
 #include "../../module.h"
 #include "bus.h"
-#include "mos6502-2a03.h"
+#include "../MOS6502/mos6502.h"
 
 namespace Cores::Nes{
 	
 	class System:public Module{
 		
+		private:
+		Bus bus;
+		Mos6502<Bus, Mos6502Variants::Ricoh2a03> cpu{bus, 0x100};
+		uint32_t frameCycles; //CPU cycles per frame
+		uint32_t carry = 0; //Cycles the last frame's final instruction ran over by
+		
 		public:
 		
 		int16_t* playAudio() override{
@@ -17,11 +23,29 @@ namespace Cores::Nes{
 		
 		void getKey() override{}
 		
-		void runCycle() override{}
+		void runCycle() override{
+			//Whole instructions run in one call until one would touch the PPU or APU registers. That
+			//one is stepped a cycle at a time, which is where the other chips get caught up to it.
+			uint32_t budget = frameCycles - std::min(carry, frameCycles);
+			uint32_t spent = 0;
+			while(spent < budget){
+				uint8_t cycles = cpu.instruction();
+				if(cycles == 0){
+					do{
+						cpu.tick(1);
+						cycles++;
+					}while(!cpu.atBoundary());
+				}
+				spent += cycles;
+				instructionCount++;
+			}
+			carry = spent - budget;
+		}
 		
 		void debugCycle() override{}
 		
 		System(int argc, std::string* args):Module("Nintendo Entertainment System", 21477272, 256, 240, 2, 48000, 60.0){
+			frameCycles = bclk/12/60; //The CPU runs off the master clock divided by 12
 			init = true;
 		}
 	};
@@ -0,0 +1,395 @@
+//x86-64 dynamic recompiler for the XO-Chip core. Enabled with --dynarec.
+//Saturday 17th of October, 2026
+#pragma once
+#if defined(__x86_64__) && defined(__unix__)
+#include <sys/mman.h>
+#include <unistd.h>
+#define MOSES_DYNAREC
+#endif
+
+namespace Cores::Xochip{
+	
+	template<typename Cpu>
+	class Dynarec{
+		//Translates straight runs of register, timer and I instructions into native code, ending at
+		//the first jump or skip (also translated) or anything it doesn't know (left to the
+		//interpreter). A block is a plain function taking a pointer to the V registers in rdi, which
+		//it uses as the base for every register it touches, and returning the next pc in eax.
+		//Blocks remember the write count of the memory pages they were built from. Once either page
+		//has been written to, the block's own bytes are compared against a copy kept behind its code,
+		//and it only gets rebuilt if they changed.
+		
+		private:
+		typedef uint32_t (*Block)(uint8_t *v);
+		static const int maxBlockOps = 32; //Keeps a block and its skip lookahead within two pages
+		static const size_t cacheSize = 4*1024*1024;
+		static const size_t maxSourceBytes = maxBlockOps*2 + 4;
+		static const size_t maxBlockBytes = maxBlockOps*24 + 16 + maxSourceBytes;
+		static const uint8_t maxRebuilds = 8; //After this many, code at a pc is taken to be self-modifying and left to the interpreter
+		struct Entry{
+			Block code = nullptr;
+			const uint8_t *source = nullptr; //The bytes the block was built from, as they were
+			uint32_t writes[2] = {};
+			uint8_t length = 0;
+			uint16_t ops = 0; //0 means the instruction at this pc goes to the interpreter
+			uint8_t pages[2] = {};
+			uint8_t rebuilds = 0;
+			bool valid = false;
+		};
+		Cpu &cpu;
+		std::vector<Entry> entries;
+		uint8_t *cache = nullptr;
+		size_t used = 0;
+		uint8_t *out = nullptr;
+		int32_t offI;
+		int32_t offDT;
+		int32_t offST;
+		
+		void byte(uint8_t val){
+			*out++ = val;
+		}
+		
+		void word(uint16_t val){
+			std::memcpy(out, &val, 2);
+			out += 2;
+		}
+		
+		void dword(uint32_t val){
+			std::memcpy(out, &val, 4);
+			out += 4;
+		}
+		
+		void mem(uint8_t reg, int32_t disp){ //ModRM for [rdi+disp32]
+			byte(0x87 | (reg << 3));
+			dword(disp);
+		}
+		
+		void load(uint8_t reg, int32_t disp){ //mov r8, [rdi+disp]
+			byte(0x8A);
+			mem(reg, disp);
+		}
+		
+		void store(uint8_t reg, int32_t disp){ //mov [rdi+disp], r8
+			byte(0x88);
+			mem(reg, disp);
+		}
+		
+		void storeWithFlag(uint8_t x, uint8_t setcc){ //setcc cl, then al to Vx and cl to VF
+			byte(0x0F);
+			byte(setcc);
+			byte(0xC1);
+			store(0, x);
+			store(1, 15);
+		}
+		
+		void skip(uint16_t addr, uint8_t cmov){
+			//Flags are already set by a compare. Falls through to addr+2, or skips the next
+			//instruction, which is four bytes long if it is LONG.
+			uint16_t next = addr + 2;
+			byte(0xB8); //mov eax, next
+			dword(next);
+			byte(0xBA); //mov edx, skipped
+			dword(next + ((cpu.bus.read16(next) == 0xF000) ? 4 : 2));
+			byte(0x0F); //cmovcc eax, edx
+			byte(cmov);
+			byte(0xC2);
+		}
+		
+		//Emits one instruction. Returns 0 if it can't be translated, 1 if the block goes on
+		//after it, 2 if it ends the block.
+		int emit(uint16_t opcode, uint16_t addr){
+			uint8_t x = (opcode & 0x0F00) >> 8;
+			uint8_t y = (opcode & 0x00F0) >> 4;
+			uint8_t nn = (opcode & 0x00FF);
+			uint16_t nnn = (opcode & 0x0FFF);
+			switch((opcode & 0xF000) >> 12){
+				case 0x01: //JP
+					byte(0xB8);
+					dword(nnn);
+					return 2;
+				case 0x03: //SE
+					byte(0x80); //cmp byte [Vx], nn
+					mem(7, x);
+					byte(nn);
+					skip(addr, 0x44);
+					return 2;
+				case 0x04: //SNE
+					byte(0x80);
+					mem(7, x);
+					byte(nn);
+					skip(addr, 0x45);
+					return 2;
+				case 0x05: //SE
+					if((opcode & 0x000F) != 0){
+						return 0;
+					}
+					load(1, x);
+					byte(0x3A); //cmp cl, [Vy]
+					mem(1, y);
+					skip(addr, 0x44);
+					return 2;
+				case 0x06: //LD
+					byte(0xC6);
+					mem(0, x);
+					byte(nn);
+					return 1;
+				case 0x07: //ADD
+					byte(0x80);
+					mem(0, x);
+					byte(nn);
+					return 1;
+				case 0x08:
+					switch(opcode & 0x000F){
+						case 0x0: //LD
+							load(0, y);
+							store(0, x);
+							return 1;
+						case 0x1: //OR
+							load(0, y);
+							byte(0x08);
+							mem(0, x);
+							return 1;
+						case 0x2: //AND
+							load(0, y);
+							byte(0x20);
+							mem(0, x);
+							return 1;
+						case 0x3: //XOR
+							load(0, y);
+							byte(0x30);
+							mem(0, x);
+							return 1;
+						case 0x4: //ADD
+							load(0, x);
+							byte(0x02);
+							mem(0, y);
+							storeWithFlag(x, 0x92); //setc
+							return 1;
+						case 0x5: //SUB
+							load(0, x);
+							byte(0x2A);
+							mem(0, y);
+							storeWithFlag(x, 0x93); //setnc
+							return 1;
+						case 0x6: //SHR
+							load(0, y);
+							byte(0xD0);
+							byte(0xE8);
+							storeWithFlag(x, 0x92);
+							return 1;
+						case 0x7: //SUBN
+							load(0, y);
+							byte(0x2A);
+							mem(0, x);
+							storeWithFlag(x, 0x93);
+							return 1;
+						case 0xE: //SHL
+							load(0, y);
+							byte(0xD0);
+							byte(0xE0);
+							storeWithFlag(x, 0x92);
+							return 1;
+						default:
+							return 0;
+					}
+				case 0x09: //SNE
+					if((opcode & 0x000F) != 0){
+						return 0;
+					}
+					load(1, x);
+					byte(0x3A);
+					mem(1, y);
+					skip(addr, 0x45);
+					return 2;
+				case 0x0A: //LD
+					byte(0x66);
+					byte(0xC7);
+					mem(0, offI);
+					word(nnn);
+					return 1;
+				case 0x0B: //JP
+					byte(0x0F); //movzx eax, byte [V0]
+					byte(0xB6);
+					mem(0, 0);
+					byte(0x05); //add eax, nnn
+					dword(nnn);
+					return 2;
+				case 0x0F:
+					if(opcode == 0xF000){
+						return 0;
+					}
+					switch(nn){
+						case 0x07: //LD
+							load(0, offDT);
+							store(0, x);
+							return 1;
+						case 0x15: //LD
+							load(0, x);
+							store(0, offDT);
+							return 1;
+						case 0x18: //LD
+							load(0, x);
+							store(0, offST);
+							return 1;
+						case 0x1E: //ADD
+							byte(0x0F);
+							byte(0xB6);
+							mem(0, x);
+							byte(0x66); //add [I], ax
+							byte(0x01);
+							mem(0, offI);
+							return 1;
+						default:
+							return 0;
+					}
+				default:
+					return 0;
+			}
+		}
+		
+		#ifdef MOSES_DYNAREC
+		//The cache is never writable and executable at once. Only the pages compile() is about to
+		//write to are made writable, and they go back to read and execute before any block runs.
+		void protect(size_t offset, int prot){
+			size_t page = sysconf(_SC_PAGESIZE);
+			size_t first = offset & ~(page - 1);
+			size_t last = std::min(cacheSize, (offset + maxBlockBytes + page - 1) & ~(page - 1));
+			if(mprotect(cache + first, last - first, prot) != 0){
+				std::cout << "GURU MEDITATION dynarec cache protection failed\n";
+			}
+		}
+		#endif
+		
+		void compile(uint16_t start){
+			Entry &entry = entries[start];
+			if(used + maxBlockBytes > cacheSize){
+				flush();
+			}
+			size_t begin = used;
+			#ifdef MOSES_DYNAREC
+			protect(begin, PROT_READ | PROT_WRITE);
+			#endif
+			out = cache + used;
+			uint16_t addr = start;
+			int ops = 0;
+			int result = 1;
+			while(ops < maxBlockOps && result == 1 && addr <= 0xFFF8){
+				uint8_t *mark = out;
+				result = emit(cpu.bus.read16(addr), addr);
+				if(result == 0){
+					out = mark;
+					break;
+				}
+				ops++;
+				addr += 2;
+			}
+			if(ops > 0){
+				if(result != 2){
+					byte(0xB8); //mov eax, addr
+					dword(addr);
+				}
+				byte(0xC3); //ret
+				entry.code = (Block)(cache + used);
+			}else{
+				entry.code = nullptr;
+			}
+			entry.length = addr + 4 - start; //Same span as the pages below
+			std::memcpy(out, cpu.bus.getMemory() + start, entry.length);
+			entry.source = out;
+			out += entry.length;
+			used = out - cache;
+			#ifdef MOSES_DYNAREC
+			protect(begin, PROT_READ | PROT_EXEC);
+			#endif
+			entry.ops = ops;
+			entry.pages[0] = start >> 8;
+			entry.pages[1] = (addr + 3) >> 8; //Covers the last opcode and a skip's lookahead
+			entry.writes[0] = cpu.bus.pageWrites[entry.pages[0]];
+			entry.writes[1] = cpu.bus.pageWrites[entry.pages[1]];
+			entry.valid = true;
+		}
+		
+		public:
+		Dynarec(Cpu &c):cpu(c){
+			#ifdef MOSES_DYNAREC
+			void *mapped = mmap(nullptr, cacheSize, PROT_READ | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if(mapped == MAP_FAILED){
+				std::cout << "GURU MEDITATION no executable memory for dynarec\n";
+				return;
+			}
+			cache = (uint8_t*)mapped;
+			entries.resize(65536);
+			offI = (uint8_t*)&cpu.i - cpu.v;
+			offDT = (uint8_t*)&cpu.dt - cpu.v;
+			offST = (uint8_t*)&cpu.st - cpu.v;
+			#else
+			std::cout << "GURU MEDITATION dynarec needs x86-64\n";
+			#endif
+		}
+		
+		~Dynarec(){
+			#ifdef MOSES_DYNAREC
+			if(cache != nullptr){
+				munmap(cache, cacheSize);
+			}
+			#endif
+		}
+		
+		bool checkInit(){
+			return cache != nullptr;
+		}
+		
+		void flush(){ //Throws away every block, for when memory changes without going through the bus
+			for(Entry &entry : entries){
+				entry.valid = false;
+				entry.rebuilds = 0;
+			}
+			used = 0;
+		}
+		
+		//Throws away the blocks built from the given pages, for a state load that changed them. Unlike
+		//writes through the bus this doesn't count towards a pc being taken as self-modifying.
+		void forget(const bool *pages){
+			for(Entry &entry : entries){
+				if(entry.valid && (pages[entry.pages[0]] || pages[entry.pages[1]])){
+					entry.valid = false;
+					entry.rebuilds = 0;
+				}
+			}
+		}
+		
+		uint32_t run(uint32_t steps){
+			//Same contract as Cpu::tick(). Blocks only run when they fit in what's left of steps,
+			//so a frame executes exactly as many instructions as it would interpreted.
+			uint32_t done = 0;
+			while(done < steps){
+				Entry &entry = entries[cpu.pc];
+				if(entry.rebuilds >= maxRebuilds){
+					cpu.tick(1);
+					done++;
+					continue;
+				}
+				if(!entry.valid){
+					compile(cpu.pc);
+				}else if(entry.writes[0] != cpu.bus.pageWrites[entry.pages[0]] || entry.writes[1] != cpu.bus.pageWrites[entry.pages[1]]){
+					//Most writes are to variables sharing a page with the code, not to the code
+					if(std::memcmp(entry.source, cpu.bus.getMemory() + cpu.pc, entry.length) == 0){
+						entry.writes[0] = cpu.bus.pageWrites[entry.pages[0]];
+						entry.writes[1] = cpu.bus.pageWrites[entry.pages[1]];
+					}else{
+						entry.rebuilds++;
+						compile(cpu.pc);
+					}
+				}
+				if(entry.ops > 0 && done + entry.ops <= steps){
+					cpu.pc = entry.code(cpu.v);
+					done += entry.ops;
+				}else{
+					cpu.tick(1);
+					done++;
+				}
+			}
+			return steps;
+		}
+	};
+}
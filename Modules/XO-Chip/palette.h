@@ -0,0 +1,166 @@
+//Palette expansion of the XO-Chip display planes into framebuffer pixels.
+//Saturday 17th of October, 2026
+#pragma once
+#ifdef __SSE2__
+#include <emmintrin.h>
+#if defined(__GNUC__)
+#include <tmmintrin.h>
+#define MOSES_PALETTE_SHUFFLE
+#endif
+#endif
+
+namespace Cores::Xochip{
+	
+	class Palette{
+		//Works on 16 pixels at a time. The four planes' bits for them are spread into one index
+		//byte per pixel, then every index is looked up at once as four byte shuffles, one per
+		//colour channel, on CPUs with SSSE3 (picked at runtime, so builds stay plain x86-64).
+		//Without it the indices are looked up one table read each, and without SSE2 everything is.
+		
+		private:
+		uint32_t colors[16] = {
+			0xFF000000,
+			0xFFFFFFFF,
+			0xFFAAAAAA,
+			0xFF555555,
+			0xFFFF0000,
+			0xFF00FF00,
+			0xFF0000FF,
+			0xFFFFFF00,
+			0xFF880000,
+			0xFF008800,
+			0xFF000088,
+			0xFF888800,
+			0xFFFF00FF,
+			0xFF00FFFF,
+			0xFF880088,
+			0xFF008888
+		};
+		uint8_t channels[4][16]; //Byte n of every colour, for the shuffles
+		bool shuffle = false;
+		
+		void splitChannels(){
+			for(int c = 0; c < 4; c++){
+				for(int a = 0; a < 16; a++){
+					channels[c][a] = colors[a] >> (c*8);
+				}
+			}
+		}
+		
+		#ifdef __SSE2__
+		static __m128i getIndices(const uint64_t *words, int shift){ //Pixels shift+15 down to shift, leftmost first
+			const __m128i bits = _mm_setr_epi8(-128, 64, 32, 16, 8, 4, 2, 1, -128, 64, 32, 16, 8, 4, 2, 1);
+			__m128i ret = _mm_setzero_si128();
+			for(int p = 0; p < 4; p++){
+				uint16_t chunk = words[p] >> shift;
+				__m128i spread = _mm_unpacklo_epi64(_mm_set1_epi8(chunk >> 8), _mm_set1_epi8(chunk & 0xFF));
+				__m128i lit = _mm_cmpeq_epi8(_mm_and_si128(spread, bits), bits);
+				ret = _mm_or_si128(ret, _mm_and_si128(lit, _mm_set1_epi8(1 << p)));
+			}
+			return ret;
+		}
+		
+		static void store(uint32_t *out, uint32_t *copy, __m128i pixels){
+			_mm_storeu_si128((__m128i*)out, pixels);
+			if(copy != nullptr){
+				_mm_storeu_si128((__m128i*)copy, pixels);
+			}
+		}
+		
+		#ifdef MOSES_PALETTE_SHUFFLE
+		__attribute__((target("ssse3")))
+		void lookupShuffle(__m128i indices, uint32_t *out, uint32_t *copy){
+			__m128i b = _mm_shuffle_epi8(_mm_loadu_si128((__m128i*)channels[0]), indices);
+			__m128i g = _mm_shuffle_epi8(_mm_loadu_si128((__m128i*)channels[1]), indices);
+			__m128i r = _mm_shuffle_epi8(_mm_loadu_si128((__m128i*)channels[2]), indices);
+			__m128i a = _mm_shuffle_epi8(_mm_loadu_si128((__m128i*)channels[3]), indices);
+			__m128i bgLow = _mm_unpacklo_epi8(b, g);
+			__m128i bgHigh = _mm_unpackhi_epi8(b, g);
+			__m128i raLow = _mm_unpacklo_epi8(r, a);
+			__m128i raHigh = _mm_unpackhi_epi8(r, a);
+			store(out, copy, _mm_unpacklo_epi16(bgLow, raLow));
+			store(out + 4, copy ? copy + 4 : nullptr, _mm_unpackhi_epi16(bgLow, raLow));
+			store(out + 8, copy ? copy + 8 : nullptr, _mm_unpacklo_epi16(bgHigh, raHigh));
+			store(out + 12, copy ? copy + 12 : nullptr, _mm_unpackhi_epi16(bgHigh, raHigh));
+		}
+		#endif
+		
+		void lookup(__m128i indices, uint32_t *out, uint32_t *copy){
+			#ifdef MOSES_PALETTE_SHUFFLE
+			if(shuffle){
+				lookupShuffle(indices, out, copy);
+				return;
+			}
+			#endif
+			alignas(16) uint8_t index[16];
+			_mm_store_si128((__m128i*)index, indices);
+			for(int a = 0; a < 16; a++){
+				out[a] = colors[index[a]];
+			}
+			if(copy != nullptr){
+				std::memcpy(copy, out, 16*sizeof(uint32_t));
+			}
+		}
+		#endif
+		
+		public:
+		Palette(){
+			splitChannels();
+			#ifdef MOSES_PALETTE_SHUFFLE
+			shuffle = __builtin_cpu_supports("ssse3");
+			#endif
+		}
+		
+		//Takes up to 16 comma separated RRGGBB hex colours, replacing the defaults in order.
+		bool load(std::string list){
+			uint32_t parsed[16]; //Nothing changes unless the whole list is valid
+			int count = 0;
+			size_t start = 0;
+			while(start <= list.size()){
+				size_t end = std::min(list.find(',', start), list.size());
+				std::string entry = list.substr(start, end - start);
+				if(count == 16 || entry.size() != 6 || entry.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos){
+					std::cout << "GURU MEDITATION invalid palette\n";
+					return false;
+				}
+				parsed[count++] = 0xFF000000 | std::stoul(entry, nullptr, 16);
+				start = end + 1;
+			}
+			std::copy(parsed, parsed + count, colors);
+			splitChannels();
+			return true;
+		}
+		
+		//Converts 64 pixels, given as the same word from each plane, into out. Doubled writes every
+		//pixel twice for lores, and copy (if not null) gets the same pixels as out.
+		void expand(const uint64_t *words, bool doubled, uint32_t *out, uint32_t *copy){
+			for(int k = 0; k < 4; k++){
+				int shift = 48 - 16*k;
+				int width = doubled ? 32 : 16;
+				uint32_t *second = (copy != nullptr) ? copy + k*width : nullptr;
+				#ifdef __SSE2__
+				__m128i indices = getIndices(words, shift);
+				if(doubled){
+					lookup(_mm_unpacklo_epi8(indices, indices), out + k*width, second);
+					lookup(_mm_unpackhi_epi8(indices, indices), out + k*width + 16, second ? second + 16 : nullptr);
+				}else{
+					lookup(indices, out + k*width, second);
+				}
+				#else
+				for(int x = 0; x < 16; x++){
+					uint8_t index = 0;
+					for(int p = 0; p < 4; p++){
+						index |= ((words[p] >> (shift + 15 - x)) & 1) << p;
+					}
+					for(int d = 0; d < width/16; d++){
+						out[k*width + x*(width/16) + d] = colors[index];
+						if(second != nullptr){
+							second[x*(width/16) + d] = colors[index];
+						}
+					}
+				}
+				#endif
+			}
+		}
+	};
+}
@@ -1,19 +1,27 @@
 //XO-Chip module for MOSES. Ostensibly to test multi-core functionality. Unofficially because I wanted to.
 //Thursday 26th June, 2025
+#pragma once
 #include "../../module.h"
+#include "dynarec.h"
+#include "palette.h"
 
 namespace Cores::Xochip{
 	
-	struct{
+	struct Bus{
 	
 		private: 
-		uint8_t mem[65536];
+		uint8_t mem[65536] = {};
 	
 		public:
 		uint8_t flagStore[16] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
 		uint8_t audBuffer[16] = {0, 0, 0, 0, 0, 0, 0, 0, 255, 255, 255, 255, 255, 255, 255, 255};
-		bool samples[128];
+		bool samples[128] = {};
+		uint32_t pageWrites[256] = {}; //Writes per 256 byte page, so the dynarec can spot stale blocks
 	
+		const uint8_t *getMemory(){ //For comparing against, not for writing behind the dynarec's back
+			return mem;
+		}
+		
 		void patternUpdate(){
 			for(int i = 0; i < 128; i++){
 				samples[i] = (audBuffer[i/8] & (1 << (8-(i % 8))));
@@ -143,17 +151,76 @@ namespace Cores::Xochip{
 				std::cout << "GURU MEDITATION mem out of bounds write\n";
 			}else{
 				mem[addr] = val;
+				pageWrites[addr >> 8]++;
+			}
+		}
+		
+		template<typename S>
+		void state(S &s){
+			s.field(mem);
+			s.field(flagStore);
+			s.field(audBuffer);
+			s.field(samples);
+		}
+	};
+	
+	struct Timing{
+		//What each instruction costs against a frame's budget. Octo's timing charges 1 for
+		//everything, so the budget is just instructions per frame. VIP timing charges rough
+		//averages of the COSMAC VIP interpreter in microseconds, against a 60Hz frame of them.
+		uint16_t cost[16] = {}; //By the first nibble
+		uint16_t fCost[256] = {}; //Charged on top of cost[0xF] for 0xFNN, by NN
+		uint64_t frame = 0; //Budget per frame if -sp isn't given, 0 to keep the default
+		
+		static Timing octo(){
+			Timing ret;
+			for(int a = 0; a < 16; a++){
+				ret.cost[a] = 1;
+			}
+			return ret;
+		}
+		
+		static Timing vip(){
+			Timing ret;
+			const uint16_t costs[16] = {109, 105, 105, 55, 55, 73, 27, 45, 200, 73, 55, 105, 164, 3800, 73, 0};
+			for(int a = 0; a < 16; a++){
+				ret.cost[a] = costs[a];
+			}
+			for(int a = 0; a < 256; a++){ //Timer, key, plane and audio ones, and anything unknown
+				ret.fCost[a] = 45;
+			}
+			ret.fCost[0x00] = 55; //LONG
+			ret.fCost[0x1E] = 86;
+			ret.fCost[0x29] = 91;
+			ret.fCost[0x30] = 91;
+			ret.fCost[0x33] = 927;
+			ret.fCost[0x55] = 605;
+			ret.fCost[0x65] = 605;
+			ret.fCost[0x75] = 605;
+			ret.fCost[0x85] = 605;
+			ret.frame = 1000000/60;
+			return ret;
+		}
+		
+		bool isUniform(){
+			for(int a = 0; a < 256; a++){
+				if(cost[a & 0x0F] != 1 || fCost[a] != 0){
+					return false;
+				}
 			}
+			return true;
 		}
-	} bus;
+	};
 	
-	struct{
+	struct Cpu{
 		//XO-Chip interpreter.
 		
 		private:
+		template<typename> friend class Dynarec;
+		Bus &bus;
 		float pitch = 4000;
 		//Register definitions
-		uint8_t v[16];
+		uint8_t v[16] = {};
 		uint16_t i = 0;
 		uint16_t pc = 0x200; //Program counter
 		uint8_t sp = 0; //Stack pointer
@@ -162,19 +229,43 @@ namespace Cores::Xochip{
 
 		//Variables for the interpreter
 		int planeSelect = 1;
-		uint16_t curOpcode;
-		uint16_t curOpcodeMSB;
-		uint16_t stack[16];
+		uint16_t curOpcode = 0;
+		uint16_t curOpcodeMSB = 0;
+		uint16_t stack[16] = {};
 		uint64_t loggedTicks = 0;
 		
 		public:
-		bool key[16];
+		bool key[16] = {};
 		bool hiresMode = false;
 		bool release = true;
 		bool breakpointReached = false;
-		uint8_t display[128][64];
+		uint64_t display[4][64][2] = {}; //[plane][row][half], bit 63 of a half is its leftmost pixel
+		uint64_t dirtyRows = ~0ull; //Display rows changed since the last drawFrame(), bit n is row n
 		uint8_t tempKey = 16;
-		uint64_t pcBreakpoint;
+		uint64_t pcBreakpoint = 0;
+		Timing timing = Timing::octo();
+		Random rng;
+		uint32_t cycles = 0; //What the last tick() spent, which can go past its budget by part of an instruction
+		
+		Cpu(Bus &b):bus(b){}
+		
+		template<typename S>
+		void state(S &s){
+			//Keys and release come from the frontend every frame, so they aren't saved.
+			s.field(pitch);
+			s.field(v);
+			s.field(i);
+			s.field(pc);
+			s.field(sp);
+			s.field(dt);
+			s.field(st);
+			s.field(planeSelect);
+			s.field(stack);
+			s.field(hiresMode);
+			s.field(tempKey);
+			s.field(display);
+			rng.state(s);
+		}
 		
 		bool getSound(){
 			return (st > 0);
@@ -245,25 +336,186 @@ namespace Cores::Xochip{
 			}
 		}
 		
-		inline void tick(uint32_t steps){
+		//Vx := DT, then skip out on Vx == or != NN, with a jump back after. True if addr holds one
+		//and it would go around again as things stand.
+		bool isDelayLoop(uint16_t addr){
+			uint16_t load = bus.read16(addr);
+			uint16_t test = bus.read16(addr+2);
+			if((load & 0xF0FF) != 0xF007 || (test & 0x0F00) != (load & 0x0F00)){
+				return false;
+			}
+			uint8_t x = (load & 0x0F00) >> 8;
+			bool equal = (v[x] == (test & 0x00FF));
+			switch((test & 0xF000) >> 12){
+				case 0x03:
+					return v[x] == dt && !equal;
+				case 0x04:
+					return v[x] == dt && equal;
+				default:
+					return false;
+			}
+		}
+		
+		//Instructions in the loop closed by the jump at pc-2 to target, if it is one that can't
+		//change anything until the keys or the delay timer do, which is only between frames.
+		//0 if it isn't.
+		uint8_t getIdleLength(uint16_t target){
+			if(target == pc - 2){
+				return 1;
+			}
+			if(target == pc - 6 && isDelayLoop(target)){
+				return 3;
+			}
+			return 0;
+		}
+		
+		uint32_t getCost(uint16_t opcode){
+			return timing.cost[opcode >> 12] + (((opcode >> 12) == 0x0F) ? timing.fCost[opcode & 0x00FF] : 0);
+		}
+		
+		//Runs out the rest of the budget in an idle loop that just went around, by charging for
+		//whole trips around it and then stepping pc through whatever part of one still fits.
+		//a and spent are tick()'s instruction and cycle counts.
+		void skipIdle(uint32_t &a, uint32_t &spent, uint32_t budget, uint8_t length){
+			if(spent >= budget){
+				return;
+			}
+			uint32_t loop = 0;
+			for(int k = 0; k < length; k++){
+				loop += getCost(bus.read16(pc + 2*k));
+			}
+			uint32_t trips = (budget - spent) / loop;
+			spent += trips * loop;
+			a += trips * length;
+			int k = 0;
+			while(spent < budget){
+				spent += getCost(bus.read16(pc + 2*k));
+				a++;
+				k++;
+			}
+			pc += (k % length) * 2;
+		}
+		
+		//The display is four planes of 128 pixel rows, each row split into two words. Lores only
+		//uses the first word of the first 32 rows, so every operation works on whole words and
+		//only plane selection and wrapping need any care.
+		void clearPlanes(int planes){
+			for(int p = 0; p < 4; p++){
+				if(planes & (1 << p)){
+					std::memset(display[p], 0, sizeof(display[p]));
+				}
+			}
+		}
+		
+		void scrollRight(){
+			for(int p = 0; p < 4; p++){
+				if(!(planeSelect & (1 << p))){
+					continue;
+				}
+				for(int y = 0; y < getScreenY(); y++){
+					if(hiresMode){
+						display[p][y][1] = (display[p][y][1] >> 4) | (display[p][y][0] << 60);
+					}
+					display[p][y][0] >>= 4;
+				}
+			}
+		}
+		
+		void scrollLeft(){
+			for(int p = 0; p < 4; p++){
+				if(!(planeSelect & (1 << p))){
+					continue;
+				}
+				for(int y = 0; y < getScreenY(); y++){
+					display[p][y][0] <<= 4;
+					if(hiresMode){
+						display[p][y][0] |= display[p][y][1] >> 60;
+						display[p][y][1] <<= 4;
+					}
+				}
+			}
+		}
+		
+		void scrollDown(int rows){
+			for(int p = 0; p < 4; p++){
+				if(planeSelect & (1 << p)){
+					std::memmove(display[p][rows], display[p][0], (getScreenY() - rows)*sizeof(display[p][0]));
+					std::memset(display[p][0], 0, rows*sizeof(display[p][0]));
+				}
+			}
+		}
+		
+		void scrollUp(int rows){
+			for(int p = 0; p < 4; p++){
+				if(planeSelect & (1 << p)){
+					std::memmove(display[p][0], display[p][rows], (getScreenY() - rows)*sizeof(display[p][0]));
+					std::memset(display[p][getScreenY() - rows], 0, rows*sizeof(display[p][0]));
+				}
+			}
+		}
+		
+		static uint64_t spriteWord(uint16_t sprite, int shift){ //A 16 pixel sprite row starting shift pixels into a word
+			if(shift <= -16 || shift >= 64){
+				return 0;
+			}
+			return (shift >= 0) ? ((uint64_t)sprite << 48) >> shift : ((uint64_t)sprite << 48) << -shift;
+		}
+		
+		bool drawRow(int plane, int row, int x, uint16_t sprite){ //Returns true on collision
+			bool collision = false;
+			for(int w = 0; w < getScreenX()/64; w++){
+				//Second copy is whatever wraps around past the right edge
+				uint64_t bits = spriteWord(sprite, x - 64*w) | spriteWord(sprite, x - 64*w - getScreenX());
+				collision |= (display[plane][row][w] & bits) != 0;
+				display[plane][row][w] ^= bits;
+			}
+			return collision;
+		}
+		
+		inline uint32_t tick(uint32_t budget){ //Runs until budget cycles are spent, returns the number of instructions executed
+			const uint16_t *cost = timing.cost; //Local, since writes through the byte registers could alias it
+			uint32_t a = 0;
+			uint32_t spent = 0;
 			uint8_t refA;
 			uint8_t refB;
 			uint8_t refC;
 			uint8_t refD;
 			uint8_t flagRef;
-			uint8_t pixelRef;
 			uint8_t planeIterator;
-			for(uint32_t a = 0; a < steps; a++){
+			#ifdef MOSES_THREADED_DISPATCH
+			//Only the first instruction goes through the switch. After that every case fetches
+			//the next opcode itself and jumps straight to its case, so the branch predictor gets a
+			//history per case instead of one shared jump.
+			static void *const labels[16] = {
+				&&op0x00, &&op0x01, &&op0x02, &&op0x03, &&op0x04, &&op0x05, &&op0x06, &&op0x07,
+				&&op0x08, &&op0x09, &&op0x0A, &&op0x0B, &&op0x0C, &&op0x0D, &&op0x0E, &&op0x0F
+			};
+			#define XOCHIP_CASE(n) case n: op##n
+			#define XOCHIP_NEXT() \
+				a++; \
+				if(spent >= budget){ \
+					goto finished; \
+				} \
+				curOpcode = bus.read16(pc); \
+				curOpcodeMSB = (curOpcode & 0xF000) >> 12; \
+				spent += cost[curOpcodeMSB]; \
+				pc+=2; \
+				goto *labels[curOpcodeMSB]
+			#else
+			#define XOCHIP_CASE(n) case n
+			#define XOCHIP_NEXT() break
+			#endif
+			for(; spent < budget; a++){
 				curOpcode = bus.read16(pc);
 				curOpcodeMSB = (curOpcode & 0xF000) >> 12;
+				spent += cost[curOpcodeMSB];
 				pc+=2;
 				switch(curOpcodeMSB){
-					case 0x00:
+					XOCHIP_CASE(0x00):
 						switch(curOpcode){
 							case 0x00E0: //CLS
-								for(int i = 0; i < 128*64; i++){
-									display[i%128][i/128] &= ~planeSelect;
-								}
+								clearPlanes(planeSelect);
+								dirtyRows = ~0ull;
 								break;
 							case 0x00EE: //RET
 								if(sp == 0){
@@ -275,74 +527,32 @@ namespace Cores::Xochip{
 								}
 								break;
 							case 0x00FB: //SCR
-								refA = (curOpcode & 0x000F);
-								for(int y = 0; y < getScreenY(); y++){
-									for(int x = getScreenX()-1; x >= 0; x--){
-										if(x < 4){
-											display[x][y] &= ~planeSelect;
-										}else{
-											pixelRef = (display[x][y] & ~planeSelect);
-											display[x][y] = (display[((x-4) & (getScreenX()-1))][y] & (planeSelect & 0x0F));
-											display[x][y] |= (pixelRef & 0x0F);
-										}
-									}
-								}
+								scrollRight();
+								dirtyRows = ~0ull;
 								break;
 							case 0x00FC: //SCL
-								refA = (curOpcode & 0x000F);
-								for(int y = 0; y < getScreenY(); y++){
-									for(int x = 0; x < getScreenX(); x++){
-										if(x >= (getScreenX()-4)){
-											display[x][y] &= ~planeSelect;
-										}else{
-											pixelRef = (display[x][y] & ~planeSelect);
-											display[x][y] = (display[((x+4) & (getScreenX()-1))][y] & (planeSelect & 0x0F));
-											display[x][y] |= (pixelRef & 0x0F);
-										}
-									}
-								}
+								scrollLeft();
+								dirtyRows = ~0ull;
 								break;
 							case 0x00FE: //LOW
 								hiresMode = false;
-								for(int i = 0; i < 128*64; i++){
-									display[i%128][i/128] = 0;
-								}
+								clearPlanes(0x0F);
+								dirtyRows = ~0ull;
 								break;
 							case 0x00FF: //HIGH
 								hiresMode = true;
-								for(int i = 0; i < 128*64; i++){
-									display[i%128][i/128] = 0;
-								}
+								clearPlanes(0x0F);
+								dirtyRows = ~0ull;
 								break;
 							default:
 								switch(((curOpcode & 0x00F0) >> 4)){
 									case 0x0C: //SCD
-										refA = (curOpcode & 0x000F);
-										for(int y = getScreenY()-1; y >= 0; y--){
-											for(int x = 0; x < getScreenX(); x++){
-												if(y < refA){
-													display[x][y] &= ~planeSelect;
-												}else{
-													pixelRef = (display[x][y] & ~planeSelect);
-													display[x][y] = (display[x][(y-refA) & (getScreenY()-1)] & (planeSelect & 0x0F));
-													display[x][y] |= (pixelRef & 0x0F);
-												}
-											}
-										}
+										scrollDown(curOpcode & 0x000F);
+										dirtyRows = ~0ull;
 										break;
 									case 0x0D: //SCU
-										refA = (curOpcode & 0x000F);
-										for(int y = 0; y < getScreenY(); y++){
-											for(int x = 0; x < getScreenX(); x++){
-												if(y >= (getScreenY()-refA)){
-													display[x][y] &= ~planeSelect;
-												}else{
-													pixelRef = (display[x][y] & ~planeSelect);
-													display[x][y] = (display[x][(y+refA) & (getScreenY()-1)] & (planeSelect & 0x0F));
-													display[x][y] |= (pixelRef & 0x0F);
-												}
-											}
-										}
+										scrollUp(curOpcode & 0x000F);
+										dirtyRows = ~0ull;
 										break;
 									default:
 										std::cout << "GURU MEDITATION unknown opcode\n";
@@ -351,11 +561,15 @@ namespace Cores::Xochip{
 								}
 								break;
 						}
-						break;
-					case 0x01: //JP
+						XOCHIP_NEXT();
+					XOCHIP_CASE(0x01): //JP
+						refA = getIdleLength(curOpcode & 0x0FFF);
 						pc = (curOpcode & 0x0FFF);
-						break;
-					case 0x02: //CALL
+						if(refA != 0){
+							skipIdle(a, spent, budget, refA);
+						}
+						XOCHIP_NEXT();
+					XOCHIP_CASE(0x02): //CALL
 						if(sp > 15){
 							std::cout << "GURU MEDITATION too many nested subroutines\n";
 						}else{
@@ -363,18 +577,18 @@ namespace Cores::Xochip{
 							sp++;
 							pc = (curOpcode & 0x0FFF);
 						}
-						break;
-					case 0x03: //SE
+						XOCHIP_NEXT();
+					XOCHIP_CASE(0x03): //SE
 						if(v[((curOpcode & 0x0F00) >> 8)] == (curOpcode & 0x00FF)){
 							(bus.read16(pc) == 0xF000) ? pc+=4 : pc+=2;
 						}
-						break;
-					case 0x04: //SNE
+						XOCHIP_NEXT();
+					XOCHIP_CASE(0x04): //SNE
 						if(v[((curOpcode & 0x0F00) >> 8)] != (curOpcode & 0x00FF)){
 							(bus.read16(pc) == 0xF000) ? pc+=4 : pc+=2;
 						}
-						break;
-					case 0x05:
+						XOCHIP_NEXT();
+					XOCHIP_CASE(0x05):
 						refA = ((curOpcode & 0x0F00) >> 8);
 						refB = ((curOpcode & 0x00F0) >> 4);
 						refC = fmin(refA, refB);
@@ -411,14 +625,14 @@ namespace Cores::Xochip{
 								getDebugInfo();
 								break;
 						}
-						break;
-					case 0x06: //LD
+						XOCHIP_NEXT();
+					XOCHIP_CASE(0x06): //LD
 						v[((curOpcode & 0x0F00) >> 8)] = (curOpcode & 0x00FF);
-						break;
-					case 0x07: //ADD
+						XOCHIP_NEXT();
+					XOCHIP_CASE(0x07): //ADD
 						v[((curOpcode & 0x0F00) >> 8)] += (curOpcode & 0x00FF);
-						break;
-					case 0x08: 
+						XOCHIP_NEXT();
+					XOCHIP_CASE(0x08): 
 						switch(curOpcode & 0x000F){
 							case 0x0: //LD
 								v[((curOpcode & 0x0F00) >> 8)] = v[((curOpcode & 0x00F0) >> 4)];
@@ -462,24 +676,24 @@ namespace Cores::Xochip{
 								getDebugInfo();
 								break;
 						}
-						break;
-					case 0x09: //SNE
+						XOCHIP_NEXT();
+					XOCHIP_CASE(0x09): //SNE
 						if((curOpcode & 0x000F) == 0){
 							if(v[((curOpcode & 0x0F00) >> 8)] != v[((curOpcode & 0x00F0) >> 4)]){
 								(bus.read16(pc) == 0xF000) ? pc+=4 : pc+=2;
 							}
 						}
-						break;
-					case 0x0A: //LD
+						XOCHIP_NEXT();
+					XOCHIP_CASE(0x0A): //LD
 						i = (curOpcode & 0x0FFF);
-						break;
-					case 0x0B: //JP
+						XOCHIP_NEXT();
+					XOCHIP_CASE(0x0B): //JP
 						pc = ((curOpcode & 0x0FFF) + v[0]);
-						break;
-					case 0x0C: //RND
-						v[((curOpcode & 0x0F00) >> 8)] = (rand() & (curOpcode & 0x00FF));
-						break;
-					case 0x0D: //DRW
+						XOCHIP_NEXT();
+					XOCHIP_CASE(0x0C): //RND
+						v[((curOpcode & 0x0F00) >> 8)] = (rng.next() & (curOpcode & 0x00FF));
+						XOCHIP_NEXT();
+					XOCHIP_CASE(0x0D): //DRW
 						refA = v[((curOpcode & 0x0F00) >> 8)];
 						refB = v[((curOpcode & 0x00F0) >> 4)];
 						refC = ((curOpcode & 0x00F) == 0) ? 16 : (curOpcode & 0x00F);
@@ -489,23 +703,21 @@ namespace Cores::Xochip{
 						for(int plane = 0; plane < 4; plane++){
 							if((planeSelect & (1 << plane))){
 								for(int y = 0; y < refC; y++){
-									for(int z = 0; z <= refD; z++){
-										flagRef = bus.read(i+(y*(1+refD))+z+(refD ? planeIterator*32 : planeIterator*refC));
-										for(int x = 0; x < 8; x++){
-											if(((flagRef & (0b10000000 >> x))) && (display[(refA+x+(z*8)) & (getScreenX()-1)][(refB+y) & (getScreenY()-1)] & (1 << plane))){
-												v[15] = true;
-											}
-											pixelRef = (display[(refA+x+(z*8)) & (getScreenX()-1)][(refB+y) & (getScreenY()-1)] & ~planeSelect);
-											display[(refA+x+(z*8)) & (getScreenX()-1)][(refB+y) & (getScreenY()-1)] ^= (((flagRef & (0b10000000 >> x)) >> (7-x)) << plane);
-											display[(refA+x+(z*8)) & (getScreenX()-1)][(refB+y) & (getScreenY()-1)] |= (pixelRef & 0x0F);
-										}
+									dirtyRows |= 1ull << ((refB+y) & (getScreenY()-1));
+									uint16_t addr = i+(y*(1+refD))+(refD ? planeIterator*32 : planeIterator*refC);
+									uint16_t sprite = bus.read(addr) << 8;
+									if(refD){
+										sprite |= bus.read(addr+1);
+									}
+									if(drawRow(plane, (refB+y) & (getScreenY()-1), refA & (getScreenX()-1), sprite)){
+										v[15] = true;
 									}
 								}
 								planeIterator++;
 							}
 						}
-						break;
-					case 0x0E:
+						XOCHIP_NEXT();
+					XOCHIP_CASE(0x0E):
 						switch((curOpcode & 0x00FF)){
 							case 0x9E: //SKP
 								if(key[v[((curOpcode & 0x0F00) >> 8)] & 0x0F]){
@@ -522,12 +734,13 @@ namespace Cores::Xochip{
 								getDebugInfo();
 							break;
 						}
-						break;
-					case 0x0F:
+						XOCHIP_NEXT();
+					XOCHIP_CASE(0x0F):
+						spent += timing.fCost[curOpcode & 0x00FF];
 						if(curOpcode == 0xF000){ //LONG
 							i = bus.read16(pc);
 							pc+=2;
-							break;
+							XOCHIP_NEXT();
 						}
 						switch(curOpcode & 0x00FF){
 							case 0x01: //DW
@@ -551,9 +764,11 @@ namespace Cores::Xochip{
 										}
 									}
 									pc-=2;
+									skipIdle(a, spent, budget, 1);
 								}else{
 									if(tempKey == 16){
 										pc-=2;
+										skipIdle(a, spent, budget, 1);
 									}else{
 										v[((curOpcode & 0x0F00) >> 8)] = tempKey;
 										tempKey = 16;
@@ -612,13 +827,20 @@ namespace Cores::Xochip{
 								getDebugInfo();
 								break;
 						}
-						break;
+						XOCHIP_NEXT();
 						default:
 							std::cout << "GURU MEDITATION unknown opcode\n";
 							getDebugInfo();
 							break;
 				}
 			}
+			#ifdef MOSES_THREADED_DISPATCH
+			finished:
+			#endif
+			#undef XOCHIP_CASE
+			#undef XOCHIP_NEXT
+			cycles = spent;
+			return a;
 		}
 		
 		std::string loggedTick(uint32_t steps){
@@ -679,45 +901,52 @@ namespace Cores::Xochip{
 				}
 			}
 		}
-	} cpu;
+	};
 
 	class System:public Module{
 		private:
-		uint32_t color[16] = { //Reminder to implement custom palettes!
-			0xFF000000,
-			0xFFFFFFFF,
-			0xFFAAAAAA,
-			0xFF555555,
-			0xFFFF0000,
-			0xFF00FF00,
-			0xFF0000FF,
-			0xFFFFFF00,
-			0xFF880000,
-			0xFF008800,
-			0xFF000088,
-			0xFF888800,
-			0xFFFF00FF,
-			0xFF00FFFF,
-			0xFF880088,
-			0xFF008888
-		};
+		static const uint16_t stateVersion = 4; //Bump whenever the state() field lists change
+		Bus bus;
+		Cpu cpu{bus};
+		Dynarec<Cpu> *dynarec = nullptr;
+		Palette palette;
 		uint64_t framesTicked = 0;
+		uint32_t carry = 0; //Cycles the last frame overran its budget by, taken out of the next one
+		std::vector<uint8_t> previousMem = std::vector<uint8_t>(65536); //What loadState() compares against
+		uint64_t previousDisplay[4][64][2];
 		
 		void drawFrame(){
+			for(int y = 0; y < 64; y++){
+				if((cpu.dirtyRows >> y) & 1){
+					cpu.hiresMode ? frameBuffer.markRows(y, 1) : frameBuffer.markRows(2*y, 2);
+				}
+			}
+			cpu.dirtyRows = 0;
+			uint64_t words[4];
 			if(cpu.hiresMode){
 				for(int y = 0; y < 64; y++){
-					for(int x = 0; x < 128; x++){
-						frameBuffer[((y*128)+x)] = color[(cpu.display[x][y] & 0x000F)];
+					if(!frameBuffer.isStale(y)){
+						continue;
+					}
+					for(int w = 0; w < 2; w++){
+						for(int p = 0; p < 4; p++){
+							words[p] = cpu.display[p][y][w];
+						}
+						palette.expand(words, false, &frameBuffer[(y*128)+(w*64)], nullptr);
 					}
 				}
 			}else{
-				for(int y = 0; y < 64; y++){
-					for(int x = 0; x < 64; x++){
-						frameBuffer[2*((y*64)+x)] =  color[(cpu.display[x][y/2] & 0x000F)];
-						frameBuffer[2*((y*64)+x)+1] =  color[(cpu.display[x][y/2] & 0x000F)];
+				for(int y = 0; y < 32; y++){ //Each lores row is two framebuffer rows, drawn together
+					if(!frameBuffer.isStale(2*y) && !frameBuffer.isStale(2*y+1)){
+						continue;
+					}
+					for(int p = 0; p < 4; p++){
+						words[p] = cpu.display[p][y][0];
 					}
+					palette.expand(words, true, &frameBuffer[(2*y)*128], &frameBuffer[(2*y+1)*128]);
 				}
 			}
+			frameBuffer.publish();
 		}
 		
 		void getKey() override{
@@ -760,10 +989,59 @@ namespace Cores::Xochip{
 			return audioSamples;
 		}
 
+		template<typename S>
+		void state(S &s){
+			bus.state(s);
+			cpu.state(s);
+			s.field(carry);
+		}
+		
+		size_t saveState(uint8_t *buffer, size_t size) override{
+			return writeState(*this, stateVersion, buffer, size);
+		}
+		
+		bool loadState(const uint8_t *buffer, size_t size) override{
+			//Runahead and rewind load a state every frame, and most of it matches what's already
+			//there. The dynarec only rebuilds blocks from pages that differ, and only display rows
+			//that differ get redrawn.
+			std::memcpy(previousMem.data(), bus.getMemory(), previousMem.size());
+			std::memcpy(previousDisplay, cpu.display, sizeof(previousDisplay));
+			bool previousHires = cpu.hiresMode;
+			bool ret = readState(*this, stateVersion, buffer, size);
+			if(dynarec != nullptr){
+				bool changed[256];
+				for(int page = 0; page < 256; page++){
+					changed[page] = std::memcmp(&previousMem[page*256], &bus.getMemory()[page*256], 256) != 0;
+				}
+				dynarec -> forget(changed);
+			}
+			if(cpu.hiresMode != previousHires){
+				cpu.dirtyRows = ~0ull;
+			}
+			for(int y = 0; y < 64; y++){
+				for(int p = 0; p < 4; p++){
+					if(cpu.display[p][y][0] != previousDisplay[p][y][0] || cpu.display[p][y][1] != previousDisplay[p][y][1]){
+						cpu.dirtyRows |= 1ull << y;
+					}
+				}
+			}
+			return ret;
+		}
+		
+		size_t getStateSize() override{
+			return measureState(*this);
+		}
+		
 		void runCycle() override{
 			getKey();
 			cpu.release = keyRelease;
-			cpu.tick(bclk);
+			if(dynarec != nullptr){
+				instructionCount += dynarec -> run(bclk);
+			}else{
+				uint32_t budget = bclk - std::min<uint64_t>(carry, bclk);
+				instructionCount += cpu.tick(budget);
+				carry = cpu.cycles - budget;
+			}
 			drawFrame();
 			cpu.decTimers();
 		}
@@ -782,7 +1060,9 @@ namespace Cores::Xochip{
 					framesTicked++;
 				}else{
 					if(!cpu.breakpointReached){
-						cpu.tick(debugStep);
+						for(uint32_t a = 0; a < debugStep; a++){ //tick() takes cycles, which aren't instructions under --timing vip
+							cpu.tick(1);
+						}
 						cpu.decTimers();
 						cpu.getDebugInfo();
 					}
@@ -792,8 +1072,10 @@ namespace Cores::Xochip{
 		}
 		
 		System(int argc, std::string* args, int speed):Module("XO-Chip", speed, 128, 64, 1, 48000, 60.0){
-			frameBuffer.resize(128*64);
+			frameBuffer.resize(128, 64);
+			frameBuffer.trackRows();
 			bool fileArg = false;
+			bool speedArg = false;
 			for(int i = 0; i < argc; i++){
 				if(args[i] == "-f"){
 					fileArg = true;
@@ -803,17 +1085,52 @@ namespace Cores::Xochip{
 					if(std::stoi(args[i+1]) < 1){
 						std::cout << "GURU MEDITATION invalid ipf setting\n";
 					}else{
+						speedArg = true;
 						bclk = std::stoi(args[i+1]);
 					}
 				}
+				if(args[i] == "--timing"){
+					if(args[i+1] == "octo"){
+						cpu.timing = Timing::octo();
+					}else if(args[i+1] == "vip"){
+						cpu.timing = Timing::vip();
+					}else{
+						std::cout << "GURU MEDITATION unknown timing\n";
+					}
+				}
+				if(args[i] == "-pal"){
+					palette.load(args[i+1]);
+				}
+				if(args[i] == "--seed"){
+					cpu.rng.reseed(std::stoull(args[i+1]));
+				}
+				if(args[i] == "--dynarec"){
+					dynarec = new Dynarec<Cpu>(cpu);
+					if(!(dynarec -> checkInit())){
+						delete dynarec;
+						dynarec = nullptr;
+					}
+				}
 			}
 			if(!fileArg){
 				std::cout << "GURU MEDITATION no file argument\n";
 			}
+			if(cpu.timing.frame != 0 && !speedArg){
+				bclk = cpu.timing.frame;
+			}
+			if(dynarec != nullptr && !cpu.timing.isUniform()){ //Blocks are charged one cycle per instruction
+				std::cout << "GURU MEDITATION dynarec needs octo timing\n";
+				delete dynarec;
+				dynarec = nullptr;
+			}
 			if(fileFound){
 				init = true;
 				bus.setup();
 			}
 		}
+		
+		~System(){
+			delete dynarec;
+		}
 	};
 }
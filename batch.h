@@ -0,0 +1,295 @@
+//Batched stepping of many CHIP-8 family instances, for regression runs and training agents.
+//Saturday 17th of October, 2026
+#pragma once
+#include "Modules/Chip8/chip8.h"
+#include "Modules/Chip8/chip8-lockstep.h"
+#include "Modules/XO-Chip/xochip.h"
+
+namespace Cores{
+	
+	class WorkerPool{
+		//Parallel-for over a fixed set of threads. Every participant (the workers plus the calling
+		//thread) gets a contiguous slice of the indices, and steals from the others once it runs dry.
+		
+		private:
+		struct alignas(64) Slice{
+			std::atomic<uint32_t> next = 0;
+			uint32_t end = 0;
+		};
+		std::vector<std::thread> threads;
+		std::vector<Slice> slices;
+		std::function<void(uint32_t)> job;
+		std::mutex lock;
+		std::condition_variable wake;
+		std::condition_variable done;
+		uint64_t generation = 0;
+		uint32_t busy = 0;
+		bool quit = false;
+		
+		void drain(Slice &slice){
+			uint32_t index;
+			while((index = slice.next.fetch_add(1, std::memory_order_relaxed)) < slice.end){
+				job(index);
+			}
+		}
+		
+		void work(uint32_t self){
+			for(uint32_t a = 0; a < slices.size(); a++){
+				drain(slices[(self + a) % slices.size()]);
+			}
+		}
+		
+		void workerLoop(uint32_t self){
+			uint64_t seen = 0;
+			while(true){
+				{
+					std::unique_lock<std::mutex> guard(lock);
+					wake.wait(guard, [&]{ return quit || generation != seen; });
+					if(quit){
+						return;
+					}
+					seen = generation;
+				}
+				work(self);
+				std::lock_guard<std::mutex> guard(lock);
+				if(--busy == 0){
+					done.notify_one();
+				}
+			}
+		}
+		
+		public:
+		WorkerPool(uint32_t threadCount):slices(std::max<uint32_t>(1, threadCount)){
+			for(uint32_t a = 1; a < slices.size(); a++){
+				threads.emplace_back(&WorkerPool::workerLoop, this, a);
+			}
+		}
+		
+		~WorkerPool(){
+			{
+				std::lock_guard<std::mutex> guard(lock);
+				quit = true;
+			}
+			wake.notify_all();
+			for(std::thread &thread : threads){
+				thread.join();
+			}
+		}
+		
+		void run(uint32_t count, std::function<void(uint32_t)> fn){
+			job = fn;
+			uint32_t per = count / slices.size();
+			uint32_t extra = count % slices.size();
+			uint32_t start = 0;
+			for(uint32_t a = 0; a < slices.size(); a++){
+				slices[a].end = start + per + (a < extra);
+				slices[a].next.store(start, std::memory_order_relaxed);
+				start = slices[a].end;
+			}
+			if(!threads.empty()){
+				std::lock_guard<std::mutex> guard(lock);
+				generation++;
+				busy = threads.size();
+			}
+			wake.notify_all();
+			work(0);
+			std::unique_lock<std::mutex> guard(lock);
+			done.wait(guard, [&]{ return busy == 0; });
+		}
+	};
+	
+	class VectorEnv{
+		//Owns N independent instances of one core and steps all of them a frame per call. Frames
+		//come back as one contiguous N x H x W tensor of BGRA32 pixels, audio as N x samples.
+		//"chip8-lockstep" runs the instances in groups of lockstepLanes through one LockstepCpu each,
+		//which pays off when they all run the same ROM and mostly take the same path. Instance n is
+		//seeded with the --seed in extraArgs (or the default) plus n, so they don't all roll alike.
+		
+		private:
+		static constexpr int lockstepLanes = 16;
+		typedef Chip8::LockstepSystem<lockstepLanes> LockstepGroup;
+		//Same layout as the cores' getKey(), so keypad bit n lands on CHIP-8 key n.
+		static constexpr SDL_Scancode keypad[16] = {
+			SDL_SCANCODE_X, SDL_SCANCODE_1, SDL_SCANCODE_2, SDL_SCANCODE_3,
+			SDL_SCANCODE_Q, SDL_SCANCODE_W, SDL_SCANCODE_E, SDL_SCANCODE_A,
+			SDL_SCANCODE_S, SDL_SCANCODE_D, SDL_SCANCODE_Z, SDL_SCANCODE_C,
+			SDL_SCANCODE_4, SDL_SCANCODE_R, SDL_SCANCODE_F, SDL_SCANCODE_V
+		};
+		struct Instance{
+			Module *sys = nullptr;
+			bool keys[SDL_SCANCODE_COUNT] = {};
+			uint16_t lastKeys = 0;
+			bool release = true; //Lockstep lanes have no Module to hold keyRelease
+		};
+		std::vector<Instance> instances;
+		std::vector<LockstepGroup*> groups;
+		std::string coreName;
+		std::vector<uint32_t> frameTensor;
+		std::vector<int16_t> audioTensor;
+		WorkerPool pool;
+		uint32_t pixels = 0;
+		uint32_t samples = 0;
+		bool init = false;
+		
+		void stepInstance(uint32_t index, uint16_t keys){
+			Instance &inst = instances[index];
+			if(keys & ~inst.lastKeys){
+				inst.sys -> keyRelease = false;
+			}else if(inst.lastKeys & ~keys){
+				inst.sys -> keyRelease = true;
+			}
+			for(int a = 0; a < 16; a++){
+				inst.keys[keypad[a]] = (keys >> a) & 1;
+			}
+			inst.lastKeys = keys;
+			inst.sys -> runCycle();
+			std::vector<uint32_t> &frame = inst.sys -> getFramebuffer();
+			std::copy(frame.begin(), frame.end(), frameTensor.begin() + (size_t)index*pixels);
+			int16_t *audio = inst.sys -> playAudio();
+			std::copy(audio, audio + samples, audioTensor.begin() + (size_t)index*samples);
+		}
+		
+		void stepGroup(uint32_t group, const uint16_t *keys){
+			LockstepGroup *sys = groups[group];
+			uint32_t first = group*lockstepLanes;
+			uint32_t last = std::min<uint32_t>(first + lockstepLanes, instances.size());
+			for(uint32_t index = first; index < last; index++){
+				Instance &inst = instances[index];
+				if(keys[index] & ~inst.lastKeys){
+					inst.release = false;
+				}else if(inst.lastKeys & ~keys[index]){
+					inst.release = true;
+				}
+				inst.lastKeys = keys[index];
+				sys -> setKeys(index - first, keys[index], inst.release);
+			}
+			sys -> runCycle();
+			for(uint32_t index = first; index < last; index++){
+				sys -> drawLane(index - first, frameTensor.data() + (size_t)index*pixels);
+				sys -> playAudio(index - first, audioTensor.data() + (size_t)index*samples);
+			}
+		}
+		
+		public:
+		VectorEnv(std::string core, uint32_t count, std::string romPath, uint32_t threadCount = std::thread::hardware_concurrency(), std::vector<std::string> extraArgs = {}):instances(count), pool(threadCount){
+			uint64_t seed = Random::defaultSeed;
+			for(size_t a = 0; a + 1 < extraArgs.size(); a++){
+				if(extraArgs[a] == "--seed"){
+					seed = std::stoull(extraArgs[a+1]);
+				}
+			}
+			std::vector<std::string> args = {"--core", core, "-f", romPath};
+			args.insert(args.end(), extraArgs.begin(), extraArgs.end());
+			args.push_back("--seed");
+			args.push_back(""); //Filled in per instance, after any --seed in extraArgs so it wins
+			int argc = args.size();
+			args.push_back(""); //Cores peek one past the last argument
+			if(core == "chip8-lockstep"){
+				for(uint32_t a = 0; a < count; a += lockstepLanes){
+					args[argc-1] = std::to_string(seed + a); //Lanes add their own index on top
+					groups.push_back(new LockstepGroup(argc, args.data()));
+					if(!(groups.back() -> checkInit())){
+						return;
+					}
+				}
+				coreName = "Chip-8 (lockstep)";
+				pixels = 64*32;
+				samples = 1800/60;
+				frameTensor.resize((size_t)count*pixels);
+				audioTensor.resize((size_t)count*samples);
+				init = true;
+				return;
+			}
+			for(uint32_t a = 0; a < count; a++){
+				Instance &inst = instances[a];
+				args[argc-1] = std::to_string(seed + a);
+				if(core == "chip8"){
+					inst.sys = new Cores::Chip8::System(argc, args.data());
+				}else if(core == "xochip"){
+					inst.sys = new Cores::Xochip::System(argc, args.data(), 1000);
+				}else if(core == "xochip-fast"){
+					inst.sys = new Cores::Xochip::System(argc, args.data(), 200000);
+				}else{
+					std::cout << "GURU MEDITATION core not batchable\n";
+					return;
+				}
+				if(!(inst.sys -> checkInit())){
+					return;
+				}
+				inst.sys -> addKey(inst.keys);
+			}
+			if(count > 0){
+				coreName = instances[0].sys -> getName();
+				WindowArgs *winArgs = instances[0].sys -> getWindowArgs();
+				pixels = winArgs -> getX() * winArgs -> getY();
+				samples = (winArgs -> getSampleFrequency()/winArgs -> getFPS()) * winArgs -> getAudioChannels();
+			}
+			frameTensor.resize((size_t)count*pixels);
+			audioTensor.resize((size_t)count*samples);
+			init = true;
+		}
+		
+		~VectorEnv(){
+			for(Instance &inst : instances){
+				delete inst.sys;
+			}
+			for(LockstepGroup *group : groups){
+				delete group;
+			}
+		}
+		
+		bool checkInit(){
+			return init;
+		}
+		
+		//keys holds one 16-bit keypad mask per instance, bit n set while CHIP-8 key n is held.
+		void step(const uint16_t *keys){
+			if(!groups.empty()){
+				pool.run(groups.size(), [&](uint32_t group){ stepGroup(group, keys); });
+			}else{
+				pool.run(instances.size(), [&](uint32_t index){ stepInstance(index, keys[index]); });
+			}
+		}
+		
+		const uint32_t* frames(){
+			return frameTensor.data();
+		}
+		
+		const int16_t* audio(){
+			return audioTensor.data();
+		}
+		
+		uint32_t size(){
+			return instances.size();
+		}
+		
+		uint32_t framePixels(){
+			return pixels;
+		}
+		
+		uint32_t audioSamples(){
+			return samples;
+		}
+		
+		std::string getName(){
+			return coreName;
+		}
+		
+		uint64_t getInstructionCount(){
+			uint64_t ret = 0;
+			for(uint32_t a = 0; a < instances.size(); a++){
+				if(!groups.empty()){
+					ret += groups[a/lockstepLanes] -> getInstructionCount(a%lockstepLanes);
+				}else{
+					ret += instances[a].sys -> getInstructionCount();
+				}
+			}
+			return ret;
+		}
+		
+		//Null in lockstep mode, where lanes aren't separate Modules.
+		Module* instance(uint32_t index){
+			return instances[index].sys;
+		}
+	};
+}
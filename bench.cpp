@@ -0,0 +1,237 @@
+//MOSES headless benchmark runner.
+/*  Copyright (C) 2025  Justin Warner
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+//File created Saturday 17th of October, 2026
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <filesystem>
+#include <cstdlib>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include "vendored/SDL3-3.2.16/include/SDL3/SDL.h"
+#include "vendored/json/include/nlohmann/json.hpp"
+#include "Modules/Chip8/chip8.h"
+#include "Modules/NES/nes.h"
+#include "Modules/AppleII/appleii.h"
+#include "Modules/XO-Chip/xochip.h"
+#include "batch.h"
+#include "benchroms.h"
+
+using namespace Cores;
+using json = nlohmann::json;
+
+struct BenchCase{
+	std::string name;
+	std::string core;
+	std::vector<uint8_t> rom; //Empty for cores that don't take a ROM yet
+	std::vector<std::string> args;
+};
+
+bool noKeys[SDL_SCANCODE_COUNT] = {};
+
+std::string writeRom(BenchCase &bench){
+	std::filesystem::path romPath = std::filesystem::temp_directory_path() / ("moses-bench-" + bench.name + ".ch8");
+	std::ofstream rom(romPath, std::ofstream::binary);
+	rom.write((const char*)bench.rom.data(), bench.rom.size());
+	rom.close();
+	return romPath.string();
+}
+
+Module* makeCore(BenchCase &bench){
+	//Mirrors the core selection in main.cpp, minus everything SDL.
+	std::vector<std::string> args = {"--core", bench.core};
+	if(!bench.rom.empty()){
+		args.push_back("-f");
+		args.push_back(writeRom(bench));
+	}
+	args.insert(args.end(), bench.args.begin(), bench.args.end());
+	int argc = args.size();
+	args.push_back(""); //Cores peek one past the last argument
+	Module *sys = nullptr;
+	if(bench.core == "chip8"){
+		sys = new Cores::Chip8::System(argc, args.data());
+	}
+	if(bench.core == "xochip"){
+		sys = new Cores::Xochip::System(argc, args.data(), 200000);
+	}
+	if(bench.core == "nes"){
+		sys = new Cores::Nes::System(argc, args.data());
+	}
+	if(sys == nullptr || !(sys -> checkInit())){
+		std::cout << "GURU MEDITATION could not start " << bench.name << "\n";
+		return nullptr;
+	}
+	sys -> addKey(noKeys);
+	return sys;
+}
+
+json runBench(BenchCase &bench, uint32_t frames){
+	json ret;
+	Module *sys = makeCore(bench);
+	if(sys == nullptr){
+		return ret;
+	}
+	for(int i = 0; i < 10; i++){ //Warm up caches and branch predictors
+		sys -> runCycle();
+	}
+	uint64_t startCount = sys -> getInstructionCount();
+	auto start = std::chrono::steady_clock::now();
+	for(uint32_t i = 0; i < frames; i++){
+		sys -> runCycle();
+	}
+	auto end = std::chrono::steady_clock::now();
+	double seconds = std::chrono::duration<double>(end - start).count();
+	uint64_t instructions = sys -> getInstructionCount() - startCount;
+	ret["name"] = bench.name;
+	ret["core"] = sys -> getName();
+	ret["frames"] = frames;
+	ret["instructions"] = instructions;
+	ret["seconds"] = seconds;
+	ret["framesPerSecond"] = frames/seconds;
+	ret["instructionsPerSecond"] = instructions/seconds;
+	ret["nsPerFrame"] = seconds*1e9/frames;
+	delete sys;
+	return ret;
+}
+
+json runBatchBench(BenchCase &bench, uint32_t frames, uint32_t count, uint32_t threads, bool lockstep){
+	//Same as runBench, but steps count instances at once through a VectorEnv.
+	json ret;
+	if(bench.core != "chip8" && bench.core != "xochip"){
+		return ret;
+	}
+	if(lockstep && bench.core != "chip8"){
+		return ret;
+	}
+	std::string core = bench.core;
+	if(core == "xochip"){
+		core = "xochip-fast";
+	}
+	if(lockstep){
+		core = "chip8-lockstep";
+	}
+	VectorEnv env(core, count, writeRom(bench), threads, bench.args);
+	if(!env.checkInit()){
+		std::cout << "GURU MEDITATION could not start " << bench.name << "\n";
+		return ret;
+	}
+	std::vector<uint16_t> keys(count, 0);
+	for(int i = 0; i < 10; i++){
+		env.step(keys.data());
+	}
+	uint64_t startCount = env.getInstructionCount();
+	auto start = std::chrono::steady_clock::now();
+	for(uint32_t i = 0; i < frames; i++){
+		env.step(keys.data());
+	}
+	auto end = std::chrono::steady_clock::now();
+	double seconds = std::chrono::duration<double>(end - start).count();
+	uint64_t instructions = env.getInstructionCount() - startCount;
+	ret["name"] = bench.name;
+	ret["core"] = env.getName();
+	ret["instances"] = count;
+	ret["threads"] = threads;
+	ret["frames"] = frames;
+	ret["instructions"] = instructions;
+	ret["seconds"] = seconds;
+	ret["framesPerSecond"] = (double)count*frames/seconds; //Environment steps across all instances
+	ret["instructionsPerSecond"] = instructions/seconds;
+	ret["nsPerFrame"] = seconds*1e9/((double)count*frames);
+	return ret;
+}
+
+int main(int argc, char* argv[]){
+	uint32_t frames = 300;
+	uint32_t instances = 0;
+	uint32_t threads = std::max<uint32_t>(1, std::thread::hardware_concurrency());
+	bool jsonOutput = false;
+	bool lockstep = false;
+	std::string only;
+	for(int i = 1; i < argc; i++){
+		std::string arg(argv[i]);
+		if(arg == "--frames" && i+1 < argc){
+			i++;
+			if(std::stoi(argv[i]) < 1){
+				std::cout << "GURU MEDITATION invalid frame count\n";
+				return 1;
+			}
+			frames = std::stoi(argv[i]);
+		}
+		if(arg == "--instances" && i+1 < argc){
+			i++;
+			instances = std::stoi(argv[i]);
+		}
+		if(arg == "--threads" && i+1 < argc){
+			i++;
+			threads = std::max(1, std::stoi(argv[i]));
+		}
+		if(arg == "--json"){
+			jsonOutput = true;
+		}
+		if(arg == "--lockstep"){
+			lockstep = true;
+		}
+		if(arg == "--case" && i+1 < argc){
+			i++;
+			only = argv[i];
+		}
+	}
+	//Draw and scroll cases run fewer instructions per frame so a full run stays under a minute.
+	std::vector<BenchCase> cases = {
+		{"chip8-alu", "chip8", Bench::aluRom, {"-sp", "20000"}},
+		{"chip8-draw", "chip8", Bench::chip8DrawRom, {"-sp", "20000", "--nodisplaywait"}},
+		{"xochip-alu", "xochip", Bench::aluRom, {}},
+		{"xochip-alu-dynarec", "xochip", Bench::aluRom, {"--dynarec"}},
+		{"xochip-draw", "xochip", Bench::withSprite(Bench::xochipDrawCode, sizeof(Bench::xochipDrawCode)), {"-sp", "20000"}},
+		{"xochip-scroll", "xochip", Bench::withSprite(Bench::xochipScrollCode, sizeof(Bench::xochipScrollCode)), {"-sp", "2000"}},
+		{"nes-idle", "nes", {}, {}}
+	};
+	json results = json::array();
+	for(BenchCase &bench : cases){
+		if(!only.empty() && bench.name != only){
+			continue;
+		}
+		json result = (instances > 0) ? runBatchBench(bench, frames, instances, threads, lockstep) : runBench(bench, frames);
+		if(result.is_null()){
+			continue;
+		}
+		results.push_back(result);
+		if(!jsonOutput){
+			std::cout << std::left << std::setw(20) << bench.name << std::right << std::fixed << std::setprecision(0);
+			std::cout << std::setw(14) << result["instructionsPerSecond"].get<double>() << " IPS";
+			std::cout << std::setw(12) << result["framesPerSecond"].get<double>() << " FPS";
+			std::cout << std::setw(14) << result["nsPerFrame"].get<double>() << " ns/frame\n";
+		}
+	}
+	if(jsonOutput){
+		json out;
+		out["frames"] = frames;
+		out["results"] = results;
+		std::cout << out.dump(4) << "\n";
+	}
+	return 0;
+}
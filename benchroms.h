@@ -0,0 +1,94 @@
+//Synthetic ROMs for moses-bench. Each one hammers a single part of the CHIP-8 family interpreters.
+//Saturday 17th of October, 2026
+#pragma once
+
+namespace Bench{
+
+	//Register arithmetic only, no display or memory traffic.
+	const std::vector<uint8_t> aluRom = {
+		0x60, 0x00, //200 LD V0, 0
+		0x61, 0x01, //202 LD V1, 1
+		0x80, 0x14, //204 ADD V0, V1
+		0x81, 0x05, //206 SUB V1, V0
+		0x82, 0x03, //208 XOR V2, V0
+		0x83, 0x16, //20A SHR V3, V1
+		0x84, 0x1E, //20C SHL V4, V1
+		0x75, 0x01, //20E ADD V5, 1
+		0x84, 0x52, //210 AND V4, V5
+		0xF5, 0x1E, //212 ADD I, V5
+		0x35, 0x00, //214 SE V5, 0
+		0x12, 0x04, //216 JP 204
+		0x12, 0x00  //218 JP 200
+	};
+
+	//Tiles 8x15 sprites across the whole Chip-8 screen, forever.
+	const std::vector<uint8_t> chip8DrawRom = {
+		0x00, 0xE0, //200 CLS
+		0xA2, 0x20, //202 LD I, 220
+		0x60, 0x00, //204 LD V0, 0
+		0x61, 0x00, //206 LD V1, 0
+		0xD0, 0x1F, //208 DRW V0, V1, 15
+		0x70, 0x08, //20A ADD V0, 8
+		0x30, 0x40, //20C SE V0, 64
+		0x12, 0x08, //20E JP 208
+		0x60, 0x00, //210 LD V0, 0
+		0x71, 0x03, //212 ADD V1, 3
+		0x31, 0x21, //214 SE V1, 33
+		0x12, 0x08, //216 JP 208
+		0x61, 0x00, //218 LD V1, 0
+		0x12, 0x08, //21A JP 208
+		0x00, 0x00, 0x00, 0x00,
+		0xFF, 0x81, 0xBD, 0xA5, 0xA5, 0xBD, 0x81, 0xFF, 0x00, 0xFF, 0x81, 0xBD, 0xA5, 0xBD, 0x81 //220 Sprite
+	};
+
+	//Two plane 16x16 sprite data shared by the XO-Chip ROMs, loaded at 240.
+	const uint8_t xochipSprite[64] = {
+		0xFF, 0xFF, 0x80, 0x01, 0xBF, 0xFD, 0xA0, 0x05, 0xAF, 0xF5, 0xA8, 0x15, 0xAB, 0xD5, 0xAA, 0x55,
+		0x55, 0xAA, 0xD5, 0xAB, 0x15, 0xA8, 0xF5, 0xAF, 0x05, 0xA0, 0xFD, 0xBF, 0x01, 0x80, 0xFF, 0xFF,
+		0x00, 0x00, 0x7F, 0xFE, 0x40, 0x02, 0x5F, 0xFA, 0x50, 0x0A, 0x57, 0xEA, 0x54, 0x2A, 0x55, 0xAA,
+		0xAA, 0x55, 0x2A, 0x54, 0xEA, 0x57, 0x0A, 0x50, 0xFA, 0x5F, 0x02, 0x40, 0xFE, 0x7F, 0x00, 0x00
+	};
+
+	//Unaligned, wrapping 16x16 draws on both planes in hires mode.
+	const uint8_t xochipDrawCode[30] = {
+		0x00, 0xFF, //200 HIGH
+		0xF3, 0x01, //202 DW 3
+		0xA2, 0x40, //204 LD I, 240
+		0x60, 0x00, //206 LD V0, 0
+		0x61, 0x00, //208 LD V1, 0
+		0xD0, 0x10, //20A DRW V0, V1, 0
+		0x70, 0x0D, //20C ADD V0, 13
+		0x30, 0x82, //20E SE V0, 130
+		0x12, 0x0A, //210 JP 20A
+		0x60, 0x00, //212 LD V0, 0
+		0x71, 0x0B, //214 ADD V1, 11
+		0x31, 0x42, //216 SE V1, 66
+		0x12, 0x0A, //218 JP 20A
+		0x61, 0x00, //21A LD V1, 0
+		0x12, 0x0A  //21C JP 20A
+	};
+
+	//One draw followed by a scroll in every direction, on both planes in hires mode.
+	const uint8_t xochipScrollCode[26] = {
+		0x00, 0xFF, //200 HIGH
+		0xF3, 0x01, //202 DW 3
+		0xA2, 0x40, //204 LD I, 240
+		0x60, 0x00, //206 LD V0, 0
+		0x61, 0x00, //208 LD V1, 0
+		0xD0, 0x10, //20A DRW V0, V1, 0
+		0x00, 0xFB, //20C SCR
+		0x00, 0xC2, //20E SCD 2
+		0x00, 0xFC, //210 SCL
+		0x00, 0xD1, //212 SCU 1
+		0x70, 0x07, //214 ADD V0, 7
+		0x71, 0x03, //216 ADD V1, 3
+		0x12, 0x0A  //218 JP 20A
+	};
+
+	std::vector<uint8_t> withSprite(const uint8_t *code, size_t size){
+		std::vector<uint8_t> ret(code, code+size);
+		ret.resize(0x40, 0);
+		ret.insert(ret.end(), xochipSprite, xochipSprite+64);
+		return ret;
+	}
+}
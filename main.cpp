@@ -23,9 +23,14 @@
 #include <cstdlib>
 #include <cmath>
 #include <cstdint>
+#include <cstring>
 #include <sstream>
+#include <atomic>
+#include <thread>
 #include "vendored/SDL3-3.2.16/include/SDL3/SDL.h"
 #include "vendored/json/include/nlohmann/json.hpp"
+#include "pacer.h"
+#include "rewind.h"
 #include "Modules/Chip8/chip8.h"
 #include "Modules/NES/nes.h"
 #include "Modules/AppleII/appleii.h"
@@ -40,6 +45,8 @@ SDL_Renderer* render;
 SDL_Texture* frameBuffer;
 SDL_AudioStream* audioOut;
 SDL_AudioSpec sampleSpec;
+std::thread emuThread;
+std::atomic<bool> emuRunning = false;
 
 void sdl_setup(WindowArgs *args){
 	if(!SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS | SDL_INIT_AUDIO)){
@@ -64,13 +71,77 @@ void sdl_setup(WindowArgs *args){
 	SDL_ResumeAudioStreamDevice(audioOut);
 }
 
-void updateDisplay(std::vector<uint32_t> *pixels, WindowArgs *args){
+bool updateDisplay(Module *sys, WindowArgs *args, bool force){
+	//Uploads only the rows that changed, and leaves the window alone when none did.
+	std::vector<uint32_t> &pixels = sys -> getFramebuffer();
+	size_t first;
+	size_t count;
+	bool dirty = sys -> getDirtyRows(first, count);
+	if(force){
+		first = 0;
+		count = args -> getY();
+	}else if(!dirty){
+		return false;
+	}
 	int scale = args -> scaleFactor;
 	int w = args -> getX();
+	SDL_Rect rows = {0, (int)first, w, (int)count};
 	SDL_SetRenderScale(render, scale, scale);
-	SDL_UpdateTexture(frameBuffer, nullptr, pixels -> data(), w*4);
+	SDL_UpdateTexture(frameBuffer, &rows, pixels.data() + first*w, w*4);
 	SDL_RenderTexture(render, frameBuffer, nullptr, nullptr);
 	SDL_RenderPresent(render);
+	return true;
+}
+
+struct FrameExtras{
+	//Optional per-frame work built on save states.
+	RewindBuffer *rewind = nullptr;
+	int runAhead = 0; //Speculative frames to show ahead of the real one
+	std::vector<uint8_t> aheadState;
+};
+
+void runFrame(Module *sys, WindowArgs *args, FrameExtras *extras){
+	//One frame of emulation, or one frame backwards while the rewind key is held.
+	if(extras -> rewind != nullptr && SDL_GetKeyboardState(nullptr)[SDL_SCANCODE_BACKSPACE]){
+		extras -> rewind -> stepBack(sys);
+	}
+	sys -> runCycle();
+	SDL_PutAudioStreamData(audioOut, sys -> playAudio(), 2*(args -> getSampleFrequency()/args -> getFPS())*(args -> getAudioChannels()));
+	if(extras -> rewind != nullptr){
+		extras -> rewind -> push(sys);
+	}
+	if(extras -> runAhead > 0){
+		//Run on with the same input and show the last of those frames, which hides the game's own
+		//input lag. The speculative frames never reach the audio stream, and get thrown away.
+		size_t size = sys -> saveState(extras -> aheadState.data(), extras -> aheadState.size());
+		uint64_t count = sys -> getInstructionCount();
+		for(int i = 0; i < extras -> runAhead; i++){
+			sys -> runCycle();
+		}
+		sys -> loadState(extras -> aheadState.data(), size);
+		sys -> setInstructionCount(count);
+	}
+}
+
+void emulationLoop(Module *sys, WindowArgs *args, FrameExtras *extras){
+	//Runs the core on its own thread, frames go out through the core's triple buffer.
+	FramePacer pacer(audioOut, args);
+	while(emuRunning.load(std::memory_order_relaxed)){
+		runFrame(sys, args, extras);
+		pacer.wait();
+	}
+}
+
+void startEmulationThread(Module *sys, WindowArgs *args, FrameExtras *extras){
+	emuRunning = true;
+	emuThread = std::thread(emulationLoop, sys, args, extras);
+}
+
+void stopEmulationThread(){
+	if(emuThread.joinable()){
+		emuRunning = false;
+		emuThread.join();
+	}
 }
 
 void scaleDisplay(WindowArgs* args, int scale){
@@ -86,14 +157,19 @@ int main(int argc, char* argv[]){
 	std::vector<bool> keyState;
 	bool debugPause = false;
 	bool dbgPauseEnable = true;
+	bool threaded = false;
+	bool exposed = true;
+	int rewindSeconds = 0;
+	FrameExtras extras;
 	Module *sys;
 	WindowArgs *winArgs;
-	double targetFPS = 60.0;
 	bool run = true;
 	std::string *arguments = new std::string[argc];
+	int argCount = argc;
 	try{
 		if(std::string(argv[1]) == "--cfg"){
-			arguments = new std::string[6];
+			arguments = new std::string[9]; //Always ends in at least one empty entry
+			argCount = 7;
 			std::string desiredCore;
 			std::string confLocation(argv[2]);
 			std::ifstream config(confLocation);
@@ -110,6 +186,15 @@ int main(int argc, char* argv[]){
 			arguments[4] = "-sc";
 			int scale = settings["cores"][desiredCore]["scale"];
 			arguments[5] = std::to_string(scale);
+			if(settings["cores"][desiredCore].contains("palette")){ //List of "RRGGBB" strings
+				std::string palette;
+				for(std::string color : settings["cores"][desiredCore]["palette"]){
+					palette += (palette.empty() ? "" : ",") + color;
+				}
+				arguments[6] = "-pal";
+				arguments[7] = palette;
+				argCount = 9;
+			}
 		}else{
 			for(int i = 1; i < argc; i++){
 				arguments[i-1] = std::string(argv[i]);
@@ -119,19 +204,19 @@ int main(int argc, char* argv[]){
 			if(argc >= 3){
 				if(arguments[1] == "chip8"){
 					coreSet = true;
-					sys = new Cores::Chip8::System(argc, arguments);
+					sys = new Cores::Chip8::System(argCount, arguments);
 				}
 				if(arguments[1] == "nes"){
 					coreSet = true;
-					sys = new Cores::Nes::System(argc, arguments);
+					sys = new Cores::Nes::System(argCount, arguments);
 				}
 				if(arguments[1] == "xochip"){
 					coreSet = true;
-					sys = new Cores::Xochip::System(argc, arguments, 1000);
+					sys = new Cores::Xochip::System(argCount, arguments, 1000);
 				}
 				if(arguments[1] == "xochip-fast"){
 					coreSet = true;
-					sys = new Cores::Xochip::System(argc, arguments, 200000);
+					sys = new Cores::Xochip::System(argCount, arguments, 200000);
 				}
 				if(!(sys -> checkInit())){
 					SDL_Quit();
@@ -171,6 +256,25 @@ int main(int argc, char* argv[]){
 					b++;
 					sys -> setLogOutput(arguments[b]);
 				}
+				if(arguments[b] == "--threaded"){
+					threaded = true;
+				}
+				if(arguments[b] == "--rewind"){
+					b++;
+					if(std::stoi(arguments[b]) < 1){
+						std::cout << "GURU MEDITATION invalid rewind length\n";
+					}else{
+						rewindSeconds = std::stoi(arguments[b]);
+					}
+				}
+				if(arguments[b] == "--runahead"){
+					b++;
+					if(std::stoi(arguments[b]) < 0){
+						std::cout << "GURU MEDITATION invalid runahead setting\n";
+					}else{
+						extras.runAhead = std::stoi(arguments[b]);
+					}
+				}
 				if(arguments[b] == "--dbgspeed"){
 					b++;
 					sys -> debugStep = stoi(arguments[b]);
@@ -190,8 +294,43 @@ int main(int argc, char* argv[]){
 	}catch(json::out_of_range){
 		std::cout << "GURU MEDITATION invalid argument\n";
 	}
+	if(run && rewindSeconds > 0){
+		if(sys -> dbg){
+			std::cout << "GURU MEDITATION rewind unavailable while debugging\n";
+		}else if(sys -> getStateSize() == 0){
+			std::cout << "GURU MEDITATION rewind not supported by " << sys -> getName() << "\n";
+		}else{
+			extras.rewind = new RewindBuffer(sys -> getStateSize(), rewindSeconds*winArgs -> getFPS(), 16*1024*1024);
+		}
+	}
+	if(run && extras.runAhead > 0){
+		if(sys -> dbg){
+			std::cout << "GURU MEDITATION runahead unavailable while debugging\n";
+			extras.runAhead = 0;
+		}else if(threaded){
+			//The real frame would reach the triple buffer before the speculative ones replace it
+			std::cout << "GURU MEDITATION runahead unavailable in threaded mode\n";
+			extras.runAhead = 0;
+		}else if(sys -> getStateSize() == 0){
+			std::cout << "GURU MEDITATION runahead not supported by " << sys -> getName() << "\n";
+			extras.runAhead = 0;
+		}else{
+			extras.aheadState.resize(sys -> getStateSize());
+		}
+	}
+	if(run && threaded){
+		if(sys -> dbg){
+			std::cout << "GURU MEDITATION threaded mode unavailable while debugging\n";
+			threaded = false;
+		}else{
+			startEmulationThread(sys, winArgs, &extras);
+		}
+	}
+	FramePacer *pacer = nullptr;
+	if(run && !threaded){
+		pacer = new FramePacer(audioOut, winArgs);
+	}
 	while(run){
-		//ulong time = SDL_GetTicksNS();
 		SDL_Event event;
 		while(SDL_PollEvent(&event)){
 			switch( event.type ){
@@ -217,6 +356,7 @@ int main(int argc, char* argv[]){
 					}
 				}
 				if(event.key.key == SDLK_ESCAPE){
+					stopEmulationThread();
 					SDL_DestroyWindow(mainWindow);
 					SDL_Quit();
 					run = false;
@@ -227,7 +367,12 @@ int main(int argc, char* argv[]){
 			case SDL_EVENT_KEY_UP:
 				sys -> keyRelease = true;
 				break;
+			case SDL_EVENT_WINDOW_EXPOSED:
+				exposed = true;
+				break;
+			case SDL_EVENT_QUIT:
 			case SDL_EVENT_WINDOW_CLOSE_REQUESTED:
+				stopEmulationThread();
 				SDL_DestroyWindow(mainWindow);
 				SDL_Quit();
 				run = false;
@@ -246,15 +391,16 @@ int main(int argc, char* argv[]){
 			}else if(!dbgPauseEnable){
 				sys -> debugCycle();
 			}
-		}else{
-			sys -> runCycle();
-			SDL_PutAudioStreamData(audioOut, sys -> playAudio(), 2*(winArgs -> getSampleFrequency()/targetFPS)*(winArgs -> getAudioChannels()));
+		}else if(!threaded){
+			runFrame(sys, winArgs, &extras);
+		}
+		if(updateDisplay(sys, winArgs, exposed)){
+			exposed = false;
+		}else if(pacer == nullptr || sys -> dbg){
+			SDL_DelayNS(1000000); //No present to block on vsync, don't spin
+		}
+		if(pacer != nullptr && !(sys -> dbg)){
+			pacer -> wait();
 		}
-		/*ulong currentTime = SDL_GetTicksNS();
-		while(currentTime < (time + (1000000000/targetFPS))){
-			currentTime = SDL_GetTicksNS();
-		}*/
-		//The framerate cap code above is commented out because it is extremely slow. Need a better solution.
-		updateDisplay(&sys -> getFramebuffer(), winArgs);
 	}
 };
@@ -45,6 +45,205 @@ namespace Cores{
 		}
 	};
 	
+	class TripleBuffer{
+		//Lock-free triple buffer for finished frames. The core draws into the back buffer and
+		//publishes it, the frontend always picks up the newest published frame without blocking.
+		//Cores that call trackRows() mark the rows they change, so only those get converted into
+		//the back buffer and uploaded by the frontend. Each row remembers the frame it last changed
+		//in, and each buffer the frame it holds, so skipped frames can't lose an update.
+		
+		private:
+		static const uint8_t freshBit = 4;
+		std::vector<uint32_t> buffers[3];
+		std::vector<uint64_t> rowFrames[3]; //Copy of changedIn as of the frame each buffer holds
+		uint64_t bufferFrames[3] = {};
+		std::vector<uint64_t> changedIn; //Frame each row last changed in, only touched by the writer
+		uint64_t frame = 1; //Frame being drawn into the back buffer
+		uint64_t shownFrame = 0; //Newest frame the reader has put on screen
+		bool tracked = false;
+		std::atomic<uint8_t> middle = 1; //Index of the shared buffer, plus freshBit when unread
+		uint8_t back = 0; //Only touched by the writer
+		uint8_t front = 2; //Only touched by the reader
+		
+		public:
+		void resize(size_t width, size_t height){
+			for(int i = 0; i < 3; i++){
+				buffers[i].resize(width*height, 0xFF000000);
+				rowFrames[i].resize(height, 0);
+			}
+			changedIn.resize(height, frame);
+		}
+		
+		uint32_t& operator[](size_t index){
+			return buffers[back][index];
+		}
+		
+		void trackRows(){
+			tracked = true;
+		}
+		
+		void markRows(size_t first, size_t count){
+			for(size_t i = first; i < first + count && i < changedIn.size(); i++){
+				changedIn[i] = frame;
+			}
+		}
+		
+		void markAll(){
+			markRows(0, changedIn.size());
+		}
+		
+		//True if the back buffer's copy of row is out of date and has to be drawn again.
+		bool isStale(size_t row){
+			return !tracked || changedIn[row] > bufferFrames[back];
+		}
+		
+		void publish(){
+			std::copy(changedIn.begin(), changedIn.end(), rowFrames[back].begin());
+			bufferFrames[back] = frame++;
+			back = middle.exchange(back | freshBit, std::memory_order_acq_rel) & ~freshBit;
+		}
+		
+		std::vector<uint32_t>& acquire(){
+			if(middle.load(std::memory_order_relaxed) & freshBit){
+				front = middle.exchange(front, std::memory_order_acq_rel) & ~freshBit;
+			}
+			return buffers[front];
+		}
+		
+		bool isTracked(){
+			return tracked;
+		}
+		
+		//Rows of the front buffer that changed since the last call, as [first, first + count).
+		//Returns false when nothing did.
+		bool takeDirtyRows(size_t &first, size_t &count){
+			size_t last = 0;
+			first = rowFrames[front].size();
+			for(size_t i = 0; i < rowFrames[front].size(); i++){
+				if(rowFrames[front][i] > shownFrame){
+					first = std::min(first, i);
+					last = i + 1;
+				}
+			}
+			shownFrame = bufferFrames[front];
+			count = (last > first) ? last - first : 0;
+			return count > 0;
+		}
+	};
+	
+	class StateWriter{
+		//Copies fields into a caller provided buffer for saveState(). Never allocates, and stops
+		//writing (and reports failure) instead of running off the end. A null buffer only counts.
+		
+		private:
+		uint8_t *data;
+		size_t size;
+		size_t pos = 0;
+		bool overflow = false;
+		
+		public:
+		StateWriter(uint8_t *buffer, size_t length){
+			data = buffer;
+			size = length;
+		}
+		
+		template<typename T>
+		void field(T &val){
+			if(pos + sizeof(T) > size){
+				overflow = true;
+				return;
+			}
+			if(data != nullptr){
+				std::memcpy(data + pos, &val, sizeof(T));
+			}
+			pos += sizeof(T);
+		}
+		
+		size_t finish(){ //Bytes written, or 0 if the buffer was too small
+			return overflow ? 0 : pos;
+		}
+	};
+	
+	class StateReader{
+		//The other half of StateWriter. Cores run the same field list through both, so the
+		//layout can't drift between saving and loading.
+		
+		private:
+		const uint8_t *data;
+		size_t size;
+		size_t pos = 0;
+		bool overflow = false;
+		
+		public:
+		StateReader(const uint8_t *buffer, size_t length){
+			data = buffer;
+			size = length;
+		}
+		
+		template<typename T>
+		void field(T &val){
+			if(pos + sizeof(T) > size){
+				overflow = true;
+				return;
+			}
+			std::memcpy(&val, data + pos, sizeof(T));
+			pos += sizeof(T);
+		}
+		
+		bool finish(){
+			return !overflow && pos == size;
+		}
+	};
+	
+	class Random{
+		//xoshiro128**, seeded through splitmix64. Every machine owns one and saves it with the rest
+		//of its state, so random numbers replay the same on any libc and don't depend on what
+		//other instances in the process are doing.
+		
+		private:
+		uint32_t words[4];
+		
+		static uint32_t rotl(uint32_t val, int k){
+			return (val << k) | (val >> (32 - k));
+		}
+		
+		public:
+		static const uint64_t defaultSeed = 0x69;
+		
+		Random(uint64_t seed = defaultSeed){
+			reseed(seed);
+		}
+		
+		void reseed(uint64_t seed){
+			for(int a = 0; a < 4; a += 2){
+				seed += 0x9E3779B97F4A7C15;
+				uint64_t z = seed;
+				z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+				z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+				z ^= (z >> 31);
+				words[a] = z;
+				words[a+1] = z >> 32;
+			}
+		}
+		
+		uint32_t next(){
+			uint32_t ret = rotl(words[1] * 5, 7) * 9;
+			uint32_t t = words[1] << 9;
+			words[2] ^= words[0];
+			words[3] ^= words[1];
+			words[1] ^= words[2];
+			words[0] ^= words[3];
+			words[2] ^= t;
+			words[3] = rotl(words[3], 11);
+			return ret;
+		}
+		
+		template<typename S>
+		void state(S &s){
+			s.field(words);
+		}
+	};
+	
 	class Module{
 		
 		protected:
@@ -55,7 +254,7 @@ namespace Cores{
 		std::string outFile;
 		char **argv;
 		int argc;
-		std::vector<uint32_t> frameBuffer;
+		TripleBuffer frameBuffer;
 		bool init = false;
 		bool fileFound = false;
 		bool doWriteLog = false;
@@ -63,6 +262,7 @@ namespace Cores{
 		int16_t *audioSamples;
 		float volume = 0.25;
 		int audioPhase = 0;
+		uint64_t instructionCount = 0; //Instructions executed by runCycle(), for benchmarking
 		
 		std::vector<uint8_t> readFile(std::string path){
 			std::vector<uint8_t> ret;
@@ -84,21 +284,78 @@ namespace Cores{
 			}
 		}
 		
+		//Every state starts with this header so a blob from another core, or an older layout of
+		//this one, gets rejected instead of loaded as garbage.
+		struct StateHeader{
+			uint32_t magic = 0x5353454D; //"MESS", MOSES Emulator Save State
+			uint32_t core = 0;
+			uint16_t version = 0;
+			uint16_t reserved = 0;
+		};
+		
+		uint32_t getStateTag(){ //FNV-1a of the core name
+			uint32_t ret = 2166136261;
+			for(char c : name){
+				ret = (ret ^ (uint8_t)c) * 16777619;
+			}
+			return ret;
+		}
+		
+		template<typename Core>
+		size_t measureState(Core &core){
+			return writeState(core, 0, nullptr, SIZE_MAX);
+		}
+		
+		template<typename Core>
+		size_t writeState(Core &core, uint16_t version, uint8_t *buffer, size_t size){
+			StateWriter out(buffer, size);
+			StateHeader header;
+			header.core = getStateTag();
+			header.version = version;
+			out.field(header);
+			out.field(audioPhase);
+			core.state(out);
+			return out.finish();
+		}
+		
+		template<typename Core>
+		bool readState(Core &core, uint16_t version, const uint8_t *buffer, size_t size){
+			StateReader in(buffer, size);
+			StateHeader header;
+			StateHeader expected;
+			in.field(header);
+			if(header.magic != expected.magic || header.core != getStateTag() || header.version != version){
+				std::cout << "GURU MEDITATION save state does not match core\n";
+				return false;
+			}
+			if(size != measureState(core)){
+				std::cout << "GURU MEDITATION save state is the wrong size\n";
+				return false;
+			}
+			in.field(audioPhase);
+			core.state(in);
+			return in.finish(); //Cores mark the display rows the state changed themselves
+		}
+		
 		Module(std::string n, int f, int w, int h, int channels, int samples, double fps){
 			winArgs = new WindowArgs(w, h, 1, channels, samples, fps);
 			int32_t samplesPerFrame = 2*channels*samples/fps;
 			audioSamples = new int16_t[samplesPerFrame];
 			name = n;
 			bclk = f;
-			srand(0x69);
 		};
 		
 		public:
 		uint32_t debugStep = 1;
-		bool keyRelease = false;
+		std::atomic<bool> keyRelease = false;
 		bool breakpointActive = false;
 		bool dbg = false;
 		
+		virtual ~Module(){
+			delete winArgs;
+			delete[] audioSamples;
+		}
+		
 		void setPcBreakpoint(uint64_t i){
 			pcBreakpoint = i;
 		}
@@ -134,12 +391,47 @@ namespace Cores{
 		
 		virtual void getKey() = 0;
 		
+		//Snapshot of everything needed to resume emulation, written into the caller's buffer.
+		//Returns the bytes used, or 0 if the buffer is too small or the core can't save yet.
+		virtual size_t saveState(uint8_t *, size_t){
+			return 0;
+		}
+		
+		virtual bool loadState(const uint8_t *, size_t){
+			std::cout << "GURU MEDITATION save states not supported by " << name << "\n";
+			return false;
+		}
+		
+		//Exact size saveState() needs, so callers can allocate once up front.
+		virtual size_t getStateSize(){
+			return 0;
+		}
+		
 		void addKey(const bool *key){
 			keyCodes = key;
 		}
 		
 		std::vector<uint32_t>& getFramebuffer(){
-			return frameBuffer;
+			return frameBuffer.acquire();
+		}
+		
+		//Rows of the last getFramebuffer() result that changed since the previous call. Cores
+		//that don't track rows report the whole frame every time.
+		bool getDirtyRows(size_t &first, size_t &count){
+			if(!frameBuffer.isTracked()){
+				first = 0;
+				count = winArgs -> getY();
+				return true;
+			}
+			return frameBuffer.takeDirtyRows(first, count);
+		}
+		
+		uint64_t getInstructionCount(){
+			return instructionCount;
+		}
+		
+		void setInstructionCount(uint64_t count){ //For frames that get thrown away, like runahead's
+			instructionCount = count;
 		}
 		
 		std::string getName(){
@@ -0,0 +1,52 @@
+//Audio-clocked frame pacing for MOSES.
+//Saturday 17th of October, 2026
+#pragma once
+#include "module.h"
+
+class FramePacer{
+	//Holds the core's frame rate with a sleep-then-spin timer, and nudges the audio stream's
+	//resampling ratio so the queued audio stays around a fixed latency instead of drifting.
+
+	private:
+	static constexpr double spinWindow = 2000000; //Sleep until this many ns before the deadline, then spin
+	static constexpr float maxRatioNudge = 0.005; //Half a percent either way is inaudible
+	static constexpr int targetFrames = 3; //Frames of audio we want sitting in the stream
+	SDL_AudioStream *stream;
+	double frameTime;
+	double deadline;
+	int bytesPerFrame;
+	float fill = 0.5; //Smoothed fill level of the stream, 0.5 is on target
+
+	public:
+	FramePacer(SDL_AudioStream *audio, Cores::WindowArgs *args){
+		stream = audio;
+		frameTime = 1000000000/args -> getFPS();
+		bytesPerFrame = 2*(args -> getSampleFrequency()/args -> getFPS())*(args -> getAudioChannels());
+		deadline = SDL_GetTicksNS() + frameTime;
+	}
+
+	void wait(){
+		int queued = SDL_GetAudioStreamQueued(stream);
+		if(queued >= 0){
+			fill = 0.95*fill + 0.05*fmin(1.0, queued/(2.0*targetFrames*bytesPerFrame));
+			SDL_SetAudioStreamFrequencyRatio(stream, 1.0 + maxRatioNudge*(2*fill - 1));
+			if(queued < bytesPerFrame){
+				deadline = SDL_GetTicksNS() + frameTime; //About to underrun, run the next frame right away.
+				return;
+			}
+			if(queued > 3*targetFrames*bytesPerFrame){
+				deadline += frameTime; //Way too much latency, let the stream drain for a frame.
+			}
+		}
+		double currentTime = SDL_GetTicksNS();
+		if(currentTime > deadline + frameTime){
+			deadline = currentTime + frameTime; //Fell more than a frame behind, don't try to catch up.
+			return;
+		}
+		if(deadline - currentTime > spinWindow){
+			SDL_DelayNS(deadline - currentTime - spinWindow);
+		}
+		while(SDL_GetTicksNS() < deadline){}
+		deadline += frameTime;
+	}
+};
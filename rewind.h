@@ -0,0 +1,177 @@
+//Rewind history for MOSES, built on the cores' save states.
+//Saturday 17th of October, 2026
+#pragma once
+#include "module.h"
+
+class RewindBuffer{
+	//Keeps the newest state whole, and every older one as a compressed XOR delta against the
+	//state after it, in a fixed ring of memory. Frame to frame most of a state doesn't change, so
+	//a delta is mostly zeroes and run-length encodes down to a handful of bytes. Stepping back
+	//undoes one delta at a time, so both directions cost one pass over a state per frame.
+	
+	private:
+	static const size_t minZeroRun = 8; //Shorter runs of unchanged bytes stay inside a literal
+	struct Entry{
+		uint32_t offset;
+		uint32_t length;
+	};
+	std::vector<uint8_t> current; //Newest state, whole
+	std::vector<uint8_t> next; //Scratch for the state being pushed
+	std::vector<uint8_t> encoded; //Scratch for its delta
+	std::vector<uint8_t> ring; //Deltas, oldest overwritten first
+	std::vector<Entry> entries; //Circular, oldest at tail
+	size_t stateSize;
+	size_t tail = 0;
+	size_t count = 0;
+	size_t head = 0; //Where the next delta goes in ring
+	bool primed = false;
+	
+	static uint8_t* putLength(uint8_t *out, size_t val){ //LEB128
+		while(val >= 0x80){
+			*out++ = (val & 0x7F) | 0x80;
+			val >>= 7;
+		}
+		*out++ = val;
+		return out;
+	}
+	
+	static const uint8_t* getLength(const uint8_t *in, size_t &val){
+		val = 0;
+		int shift = 0;
+		while(*in & 0x80){
+			val |= (size_t)(*in++ & 0x7F) << shift;
+			shift += 7;
+		}
+		val |= (size_t)(*in++) << shift;
+		return in;
+	}
+	
+	size_t skipUnchanged(size_t pos){
+		uint64_t a;
+		uint64_t b;
+		while(pos + 8 <= stateSize){
+			std::memcpy(&a, next.data() + pos, 8);
+			std::memcpy(&b, current.data() + pos, 8);
+			if(a != b){
+				break;
+			}
+			pos += 8;
+		}
+		while(pos < stateSize && next[pos] == current[pos]){
+			pos++;
+		}
+		return pos;
+	}
+	
+	size_t encode(){
+		//Delta is a list of (unchanged run, literal run, literal XOR bytes) until the state is covered.
+		uint8_t *out = encoded.data();
+		size_t pos = 0;
+		while(pos < stateSize){
+			size_t start = pos;
+			pos = skipUnchanged(pos);
+			out = putLength(out, pos - start);
+			start = pos;
+			size_t run = 0;
+			while(pos < stateSize && run < minZeroRun){
+				run = (next[pos] == current[pos]) ? run + 1 : 0;
+				pos++;
+			}
+			pos -= run;
+			out = putLength(out, pos - start);
+			for(size_t a = start; a < pos; a++){
+				*out++ = next[a] ^ current[a];
+			}
+		}
+		return out - encoded.data();
+	}
+	
+	void decode(const Entry &entry){
+		const uint8_t *in = ring.data() + entry.offset;
+		const uint8_t *end = in + entry.length;
+		size_t pos = 0;
+		size_t run;
+		while(in < end){
+			in = getLength(in, run);
+			pos += run;
+			in = getLength(in, run);
+			for(size_t a = 0; a < run; a++){
+				current[pos++] ^= *in++;
+			}
+		}
+	}
+	
+	Entry& oldest(){
+		return entries[tail];
+	}
+	
+	void dropOldest(){
+		tail = (tail + 1) % entries.size();
+		count--;
+	}
+	
+	void store(size_t length){
+		if(length > ring.size()){
+			count = 0; //Can't fit even alone, history has to restart here
+			head = 0;
+			return;
+		}
+		if(head + length > ring.size()){
+			while(count > 0 && oldest().offset >= head){ //Leftovers from the last lap are the oldest
+				dropOldest();
+			}
+			head = 0;
+		}
+		while(count > 0 && (count == entries.size() || (oldest().offset < head + length && oldest().offset + oldest().length > head))){
+			dropOldest();
+		}
+		std::memcpy(ring.data() + head, encoded.data(), length);
+		entries[(tail + count) % entries.size()] = {(uint32_t)head, (uint32_t)length};
+		count++;
+		head += length;
+	}
+	
+	bool pop(){
+		if(count == 0){
+			return false;
+		}
+		Entry &newest = entries[(tail + count - 1) % entries.size()];
+		decode(newest);
+		head = newest.offset;
+		count--;
+		return true;
+	}
+	
+	public:
+	RewindBuffer(size_t size, size_t frames, size_t bytes){
+		stateSize = size;
+		current.resize(size);
+		next.resize(size);
+		encoded.resize(size + (size/minZeroRun + 1)*2*sizeof(size_t) + 16); //Worst case, every byte changed
+		ring.resize(std::min<size_t>(bytes, UINT32_MAX));
+		entries.resize(std::max<size_t>(1, frames));
+	}
+	
+	//Call once per emulated frame, after runCycle().
+	void push(Cores::Module *sys){
+		if(sys -> saveState(next.data(), stateSize) != stateSize){
+			return;
+		}
+		if(primed){
+			store(encode());
+		}
+		std::swap(current, next);
+		primed = true;
+	}
+	
+	//Puts the core back two frames, so the runCycle() and push() that follow land one frame
+	//earlier than before. Returns false once the history runs out.
+	bool stepBack(Cores::Module *sys){
+		if(count < 2){
+			return false;
+		}
+		pop();
+		pop();
+		return sys -> loadState(current.data(), stateSize);
+	}
+};